@@ -2,13 +2,94 @@
 #include <vector>
 #include <map>
 #include <algorithm>
-#include <functional>
 #include <string>
 #include <fstream>
 #include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <ctime>
+#include <set>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <random>
+#include <memory>
 
 using namespace std;
 
+// ======================================
+// Stock Counter
+// ======================================
+// Concurrent sessions take and return stock with compare-and-swap, so two
+// buyers can never both get the last unit and the count never goes
+// negative. Reading is a plain atomic load. Copies take a snapshot, which
+// keeps Product a copyable aggregate. A counter can be attached to one in
+// the shared catalog, so every process moves the same stock.
+class StockCounter
+{
+private:
+    atomic<int> local;
+    atomic<int> *value; // local, or the shared counter it is attached to
+
+public:
+    StockCounter(int stock = 0) : local(stock), value(&local) {}
+    StockCounter(const StockCounter &other) : local(other.value->load()), value(&local) {}
+    StockCounter &operator=(const StockCounter &other) { value->store(other.value->load()); return *this; }
+    StockCounter &operator=(int stock) { value->store(stock); return *this; }
+    operator int() const { return value->load(); }
+
+    void attach(atomic<int> *shared) { value = shared; }
+    void detach() { local.store(value->load()); value = &local; }
+    bool attachedTo(const atomic<int> *shared) const { return value == shared; }
+
+    // Takes quantity units only if that many are left
+    bool take(int quantity)
+    {
+        int current = value->load();
+        while (current >= quantity)
+        {
+            if (value->compare_exchange_weak(current, current - quantity))
+                return true;
+        }
+        return false;
+    }
+
+    void give(int quantity) { value->fetch_add(quantity); }
+};
+
+istream &operator>>(istream &in, StockCounter &counter)
+{
+    int stock;
+    if (in >> stock)
+        counter = stock;
+    return in;
+}
+
 // ======================================
 // Product Structure
 // ======================================
@@ -18,1828 +99,9858 @@ struct Product
     string name;
     float price;
     float discount;
-    int stock;
+    StockCounter stock;
     string category;
-    Product *left;
-    Product *right;
+    Product *left; // next item when a product copy is chained into a cart or wishlist
+    int categoryId; // interned category, assigned by CategoryIndex
+    int bookedStock; // stock as the stock index and analytics last recorded it
+    StockCounter held; // units taken into carts and not sold yet
 };
 
+// Stock as it is persisted. Units held in carts still belong to the shop,
+// so a crash that loses the carts puts them back on the shelf.
+int shelfStock(const Product &product)
+{
+    return int(product.stock) + int(product.held);
+}
+
 // ======================================
-// Order Structure for Customers
+// Product Arena
 // ======================================
-struct Order
+// Products are carved out of large contiguous chunks instead of being
+// allocated one by one, so products loaded together sit next to each
+// other in memory and full scans stream through cache lines.
+const int PRODUCT_CHUNK_SIZE = 4096;
+
+class ProductArena
 {
-    int code;
-    string productName;
-    int quantity;
-    float totalCost;
-    Order *next;
+private:
+    vector<Product *> chunks;
+    vector<Product *> freeList;
+    int usedInLastChunk;
+    mutex lock; // products are filled in before the catalog lock is taken
+
+public:
+    ProductArena() : usedInLastChunk(PRODUCT_CHUNK_SIZE) {}
+    ~ProductArena()
+    {
+        for (Product *chunk : chunks)
+            delete[] chunk;
+    }
+
+    Product *allocate()
+    {
+        lock_guard<mutex> guard(lock);
+        if (!freeList.empty())
+        {
+            Product *product = freeList.back();
+            freeList.pop_back();
+            return product;
+        }
+        if (usedInLastChunk == PRODUCT_CHUNK_SIZE)
+        {
+            chunks.push_back(new Product[PRODUCT_CHUNK_SIZE]);
+            usedInLastChunk = 0;
+        }
+        return &chunks.back()[usedInLastChunk++];
+    }
+
+    void release(Product *product)
+    {
+        lock_guard<mutex> guard(lock);
+        product->name.clear();
+        product->category.clear();
+        product->left = nullptr;
+        product->stock.detach();
+        product->held.detach();
+        product->held = 0;
+        freeList.push_back(product);
+    }
 };
 
 // ======================================
-// Customer Structure
+// Product Index (B+tree keyed by product code)
 // ======================================
-struct Customer
+// Nodes are fat (dozens of keys stored contiguously) so a lookup touches
+// only a handful of cache lines, and leaves are chained in code order so
+// full scans never walk back up the tree.
+const int INDEX_NODE_KEYS = 32;
+const int INDEX_MIN_KEYS = INDEX_NODE_KEYS / 2;
+const int INDEX_MAX_DEPTH = 16;
+
+struct IndexNode
 {
-    string username;
-    string password;
-    int loyaltyPoints;
-    Order *orderHistory;
-    Product *wishlist;
-    Customer *next;
+    bool leaf;
+    int count;
+    int keys[INDEX_NODE_KEYS];
 };
 
-// ======================================
-// Shopping Class
-// ======================================
-class Shopping
+struct IndexLeaf : IndexNode
 {
-private:
-    Product *productRoot;
-    Customer *customerHead;
-    Product *cartHead;
-    Customer *currentCustomer;
+    Product *products[INDEX_NODE_KEYS];
+    IndexLeaf *next;
+};
 
-public:
-    Shopping() 
-        : productRoot(nullptr), 
-          customerHead(nullptr), 
-          cartHead(nullptr), 
-          currentCustomer(nullptr) 
-    {}
+// children[i] holds codes in [keys[i-1], keys[i])
+struct IndexInner : IndexNode
+{
+    IndexNode *children[INDEX_NODE_KEYS + 1];
+};
 
-    // ---------- Main menus ----------
-    void menu();
-    void administrator();
-    void buyer();
+class ProductIndex
+{
+private:
+    IndexNode *root;
+    IndexLeaf *head;
+    int size;
 
-    // ---------- Admin login ----------
-    bool adminLogin();
+    // Position of the first key greater than code
+    static int upperBound(const IndexNode *node, int code)
+    {
+        return int(upper_bound(node->keys, node->keys + node->count, code) - node->keys);
+    }
 
-    // ---------- Administrator functionalities ----------
-    void addProduct();
-    void editProduct();
-    void deleteProduct();
-    void listProducts();
-    void listProductsByCategory();
-    void lowStockAlert();
-    void sortProductsByField(int field);
-    void createPromotion();
-    void viewAnalytics();
+    static int lowerBound(const IndexNode *node, int code)
+    {
+        return int(lower_bound(node->keys, node->keys + node->count, code) - node->keys);
+    }
 
-    // ---------- Buyer functionalities ----------
-    void customerLogin();
-    void customerRegistration();
-    void placeOrder();
-    void viewOrderHistory();
-    void addToWishlist(int code);
-    void viewWishlist();
-    void addToCart(int code, int quantity);
-    void modifyCart();
-    void displayCart();
+    static IndexLeaf *newLeaf()
+    {
+        IndexLeaf *leaf = new IndexLeaf;
+        leaf->leaf = true;
+        leaf->count = 0;
+        leaf->next = nullptr;
+        return leaf;
+    }
 
-    // ---------- Search functionalities ----------
-    void searchProductByName(string name);
-    void searchProductByPriceRange(float minPrice, float maxPrice);
+    static IndexInner *newInner()
+    {
+        IndexInner *inner = new IndexInner;
+        inner->leaf = false;
+        inner->count = 0;
+        return inner;
+    }
 
-    // ---------- Reports/Utilities ----------
-    void generateSalesReport();
-    void saveAllProducts();
-    void loadProductsOnStartup();
+    void destroy(IndexNode *node)
+    {
+        if (!node) return;
+        if (!node->leaf)
+        {
+            IndexInner *inner = static_cast<IndexInner *>(node);
+            for (int i = 0; i <= inner->count; i++)
+                destroy(inner->children[i]);
+            delete inner;
+        }
+        else
+        {
+            delete static_cast<IndexLeaf *>(node);
+        }
+    }
 
-    // ---------- Internal utility functions ----------
-private:
-    // BST helpers
-    Product *findProduct(Product *root, int code);
-    Product *addProductToTree(Product *root, Product *newProduct);
-    Product *deleteProductFromTree(Product *root, int code);
-    Product *findMin(Product *root);
+    // Inserts separator/child pair into a parent, splitting upwards as needed
+    void insertIntoParent(IndexInner **path, int *slots, int depth, int separator, IndexNode *rightChild)
+    {
+        while (depth > 0)
+        {
+            IndexInner *parent = path[depth - 1];
+            int slot = slots[depth - 1];
 
-    void inOrderTraversal(Product *root);
-    void inOrderTraversal(Product *root, const string &filter, const string &filterType);
-    void inOrderTraversal(Product *root, float minPrice, float maxPrice);
+            if (parent->count < INDEX_NODE_KEYS)
+            {
+                for (int i = parent->count; i > slot; i--)
+                {
+                    parent->keys[i] = parent->keys[i - 1];
+                    parent->children[i + 1] = parent->children[i];
+                }
+                parent->keys[slot] = separator;
+                parent->children[slot + 1] = rightChild;
+                parent->count++;
+                return;
+            }
 
-    // Saving product data
-    void saveProductsToFile(Product *root, ofstream &file);
+            // Parent is full: build the overfull key/child lists, then split
+            int keys[INDEX_NODE_KEYS + 1];
+            IndexNode *children[INDEX_NODE_KEYS + 2];
+            for (int i = 0, k = 0; i < parent->count; i++)
+            {
+                if (i == slot) keys[k++] = separator;
+                keys[k++] = parent->keys[i];
+            }
+            if (slot == parent->count) keys[parent->count] = separator;
+            for (int i = 0, k = 0; i <= parent->count; i++)
+            {
+                children[k++] = parent->children[i];
+                if (i == slot) children[k++] = rightChild;
+            }
 
-    // Not strictly necessary here (used in your original code)
-    void saveProductStockToFile(ofstream &productFile, Product *root) {}
-};
+            int total = INDEX_NODE_KEYS + 1;
+            int mid = total / 2;
+            IndexInner *sibling = newInner();
 
-// ========== ADMIN LOGIN ==========
-bool Shopping::adminLogin()
-{
-    const string ADMIN_USERNAME = "admin";
-    const string ADMIN_PASSWORD = "admin123";
+            parent->count = mid;
+            for (int i = 0; i < mid; i++)
+            {
+                parent->keys[i] = keys[i];
+                parent->children[i] = children[i];
+            }
+            parent->children[mid] = children[mid];
 
-    string username, password;
-    cout << "Enter admin username: ";
-    cin >> username;
-    cout << "Enter admin password: ";
-    cin >> password;
+            sibling->count = total - mid - 1;
+            for (int i = 0; i < sibling->count; i++)
+            {
+                sibling->keys[i] = keys[mid + 1 + i];
+                sibling->children[i] = children[mid + 1 + i];
+            }
+            sibling->children[sibling->count] = children[total];
 
-    if (username == ADMIN_USERNAME && password == ADMIN_PASSWORD)
-    {
-        cout << "Admin login successful!\n";
-        return true;
+            separator = keys[mid];
+            rightChild = sibling;
+            depth--;
+        }
+
+        // Split reached the root: grow the tree by one level
+        IndexInner *newRoot = newInner();
+        newRoot->count = 1;
+        newRoot->keys[0] = separator;
+        newRoot->children[0] = root;
+        newRoot->children[1] = rightChild;
+        root = newRoot;
     }
-    else
+
+    // Fixes an underfull node at path depth by borrowing from or merging with a sibling
+    void rebalance(IndexInner **path, int *slots, int depth, IndexNode *node)
     {
-        cout << "Invalid admin credentials.\n";
-        return false;
-    }
-}
+        while (depth > 0)
+        {
+            int minKeys = node->leaf ? INDEX_MIN_KEYS : INDEX_MIN_KEYS - 1;
+            if (node->count >= minKeys)
+                return;
 
-// ========== FIND PRODUCT IN BST ==========
-Product *Shopping::findProduct(Product *root, int code)
-{
-    // Standard BST search
-    if (!root)
-        return nullptr;
+            IndexInner *parent = path[depth - 1];
+            int slot = slots[depth - 1];
+            IndexNode *left = slot > 0 ? parent->children[slot - 1] : nullptr;
+            IndexNode *right = slot < parent->count ? parent->children[slot + 1] : nullptr;
 
-    if (root->code == code)
-        return root;
+            if (node->leaf)
+            {
+                IndexLeaf *leafNode = static_cast<IndexLeaf *>(node);
+                IndexLeaf *leftLeaf = static_cast<IndexLeaf *>(left);
+                IndexLeaf *rightLeaf = static_cast<IndexLeaf *>(right);
+
+                if (leftLeaf && leftLeaf->count > INDEX_MIN_KEYS)
+                {
+                    for (int i = leafNode->count; i > 0; i--)
+                    {
+                        leafNode->keys[i] = leafNode->keys[i - 1];
+                        leafNode->products[i] = leafNode->products[i - 1];
+                    }
+                    leftLeaf->count--;
+                    leafNode->keys[0] = leftLeaf->keys[leftLeaf->count];
+                    leafNode->products[0] = leftLeaf->products[leftLeaf->count];
+                    leafNode->count++;
+                    parent->keys[slot - 1] = leafNode->keys[0];
+                    return;
+                }
+                if (rightLeaf && rightLeaf->count > INDEX_MIN_KEYS)
+                {
+                    leafNode->keys[leafNode->count] = rightLeaf->keys[0];
+                    leafNode->products[leafNode->count] = rightLeaf->products[0];
+                    leafNode->count++;
+                    rightLeaf->count--;
+                    for (int i = 0; i < rightLeaf->count; i++)
+                    {
+                        rightLeaf->keys[i] = rightLeaf->keys[i + 1];
+                        rightLeaf->products[i] = rightLeaf->products[i + 1];
+                    }
+                    parent->keys[slot] = rightLeaf->keys[0];
+                    return;
+                }
+
+                // Merge with a sibling; always fold the right leaf into the left one
+                int separatorSlot = leftLeaf ? slot - 1 : slot;
+                IndexLeaf *into = leftLeaf ? leftLeaf : leafNode;
+                IndexLeaf *from = leftLeaf ? leafNode : rightLeaf;
+                for (int i = 0; i < from->count; i++)
+                {
+                    into->keys[into->count + i] = from->keys[i];
+                    into->products[into->count + i] = from->products[i];
+                }
+                into->count += from->count;
+                into->next = from->next;
+                delete from;
+                removeFromInner(parent, separatorSlot);
+            }
+            else
+            {
+                IndexInner *innerNode = static_cast<IndexInner *>(node);
+                IndexInner *leftInner = static_cast<IndexInner *>(left);
+                IndexInner *rightInner = static_cast<IndexInner *>(right);
+
+                if (leftInner && leftInner->count > INDEX_MIN_KEYS - 1)
+                {
+                    innerNode->children[innerNode->count + 1] = innerNode->children[innerNode->count];
+                    for (int i = innerNode->count; i > 0; i--)
+                    {
+                        innerNode->keys[i] = innerNode->keys[i - 1];
+                        innerNode->children[i] = innerNode->children[i - 1];
+                    }
+                    innerNode->keys[0] = parent->keys[slot - 1];
+                    innerNode->children[0] = leftInner->children[leftInner->count];
+                    innerNode->count++;
+                    parent->keys[slot - 1] = leftInner->keys[leftInner->count - 1];
+                    leftInner->count--;
+                    return;
+                }
+                if (rightInner && rightInner->count > INDEX_MIN_KEYS - 1)
+                {
+                    innerNode->keys[innerNode->count] = parent->keys[slot];
+                    innerNode->children[innerNode->count + 1] = rightInner->children[0];
+                    innerNode->count++;
+                    parent->keys[slot] = rightInner->keys[0];
+                    for (int i = 0; i < rightInner->count - 1; i++)
+                    {
+                        rightInner->keys[i] = rightInner->keys[i + 1];
+                        rightInner->children[i] = rightInner->children[i + 1];
+                    }
+                    rightInner->children[rightInner->count - 1] = rightInner->children[rightInner->count];
+                    rightInner->count--;
+                    return;
+                }
+
+                int separatorSlot = leftInner ? slot - 1 : slot;
+                IndexInner *into = leftInner ? leftInner : innerNode;
+                IndexInner *from = leftInner ? innerNode : rightInner;
+                into->keys[into->count] = parent->keys[separatorSlot];
+                for (int i = 0; i < from->count; i++)
+                {
+                    into->keys[into->count + 1 + i] = from->keys[i];
+                    into->children[into->count + 1 + i] = from->children[i];
+                }
+                into->children[into->count + 1 + from->count] = from->children[from->count];
+                into->count += from->count + 1;
+                delete from;
+                removeFromInner(parent, separatorSlot);
+            }
 
-    if (code < root->code)
-        return findProduct(root->left, code);
-    else
-        return findProduct(root->right, code);
-}
+            node = parent;
+            depth--;
+        }
 
-// ========== ADD PRODUCT TO BST ==========
-Product *Shopping::addProductToTree(Product *root, Product *newProduct)
-{
-    if (!root)
-        return newProduct;
+        // Root inner node emptied by a merge: shrink the tree by one level
+        if (!root->leaf && root->count == 0)
+        {
+            IndexInner *oldRoot = static_cast<IndexInner *>(root);
+            root = oldRoot->children[0];
+            delete oldRoot;
+        }
+    }
 
-    if (newProduct->code == root->code)
+    // Drops keys[slot] and children[slot + 1] from an inner node
+    static void removeFromInner(IndexInner *inner, int slot)
     {
-        cout << "Error: Duplicate product code. Product not added.\n";
-        return root;
+        for (int i = slot; i < inner->count - 1; i++)
+        {
+            inner->keys[i] = inner->keys[i + 1];
+            inner->children[i + 1] = inner->children[i + 2];
+        }
+        inner->count--;
     }
 
-    if (newProduct->code < root->code)
-        root->left = addProductToTree(root->left, newProduct);
-    else
-        root->right = addProductToTree(root->right, newProduct);
+public:
+    ProductIndex() : root(nullptr), head(nullptr), size(0) {}
+    ~ProductIndex() { destroy(root); }
 
-    return root;
-}
+    bool empty() const { return size == 0; }
+    int count() const { return size; }
 
-// ========== FIND MIN FOR BST DELETION ==========
-Product *Shopping::findMin(Product *root)
-{
-    while (root && root->left != nullptr)
-        root = root->left;
-    return root;
-}
+    // First leaf in code order; walk the chain with leaf->next
+    IndexLeaf *firstLeaf() const { return head; }
 
-// ========== DELETE PRODUCT FROM BST ==========
-Product *Shopping::deleteProductFromTree(Product *root, int code)
-{
-    if (!root)
+    // Iterates products in code order by walking the leaf chain
+    class iterator
     {
-        cout << "Error: Product not found. Cannot delete.\n";
-        return nullptr;
-    }
+    private:
+        IndexLeaf *leaf;
+        int slot;
+
+    public:
+        iterator(IndexLeaf *leaf, int slot) : leaf(leaf), slot(slot) {}
+
+        Product *operator*() const { return leaf->products[slot]; }
+
+        iterator &operator++()
+        {
+            if (++slot == leaf->count)
+            {
+                leaf = leaf->next;
+                slot = 0;
+            }
+            return *this;
+        }
+
+        bool operator!=(const iterator &other) const
+        {
+            return leaf != other.leaf || slot != other.slot;
+        }
+    };
+
+    iterator begin() const { return iterator(head, 0); }
+    iterator end() const { return iterator(nullptr, 0); }
 
-    if (code < root->code)
+    // Iterator at the first product whose code is not below code
+    iterator seek(int code) const
     {
-        root->left = deleteProductFromTree(root->left, code);
+        const IndexNode *node = root;
+        if (!node) return end();
+        while (!node->leaf)
+        {
+            const IndexInner *inner = static_cast<const IndexInner *>(node);
+            node = inner->children[upperBound(inner, code)];
+        }
+        IndexLeaf *leaf = static_cast<IndexLeaf *>(const_cast<IndexNode *>(node));
+        int slot = lowerBound(leaf, code);
+        if (slot == leaf->count)
+        {
+            leaf = leaf->next;
+            slot = 0;
+        }
+        return iterator(leaf, slot);
     }
-    else if (code > root->code)
+
+    Product *find(int code) const
     {
-        root->right = deleteProductFromTree(root->right, code);
+        const IndexNode *node = root;
+        if (!node) return nullptr;
+        while (!node->leaf)
+        {
+            const IndexInner *inner = static_cast<const IndexInner *>(node);
+            node = inner->children[upperBound(inner, code)];
+        }
+        const IndexLeaf *leaf = static_cast<const IndexLeaf *>(node);
+        int slot = lowerBound(leaf, code);
+        if (slot < leaf->count && leaf->keys[slot] == code)
+            return leaf->products[slot];
+        return nullptr;
     }
-    else
+
+    // Returns false if the code is already present
+    bool insert(Product *product)
     {
-        // Product found
-        // Node with zero or one child
-        if (!root->left)
+        int code = product->code;
+        if (!root)
         {
-            Product *temp = root->right;
-            delete root;
-            return temp;
+            head = newLeaf();
+            root = head;
         }
-        if (!root->right)
+
+        IndexInner *path[INDEX_MAX_DEPTH];
+        int slots[INDEX_MAX_DEPTH];
+        int depth = 0;
+        IndexNode *node = root;
+        while (!node->leaf)
         {
-            Product *temp = root->left;
-            delete root;
-            return temp;
+            IndexInner *inner = static_cast<IndexInner *>(node);
+            path[depth] = inner;
+            slots[depth] = upperBound(inner, code);
+            node = inner->children[slots[depth]];
+            depth++;
         }
-        // Node with two children
-        Product *temp = findMin(root->right);
-        root->code = temp->code;
-        root->name = temp->name;
-        root->price = temp->price;
-        root->discount = temp->discount;
-        root->stock = temp->stock;
-        root->category = temp->category;
-        root->right = deleteProductFromTree(root->right, temp->code);
-    }
 
-    return root;
-}
+        IndexLeaf *leaf = static_cast<IndexLeaf *>(node);
+        int pos = lowerBound(leaf, code);
+        if (pos < leaf->count && leaf->keys[pos] == code)
+            return false;
 
-// ========== LOAD PRODUCTS ON STARTUP ==========
-void Shopping::loadProductsOnStartup()
-{
-    ifstream file("products.txt");
-    if (!file)
-    {
-        cout << "No product data file found. Starting with an empty inventory.\n";
-        return;
-    }
+        if (leaf->count < INDEX_NODE_KEYS)
+        {
+            for (int i = leaf->count; i > pos; i--)
+            {
+                leaf->keys[i] = leaf->keys[i - 1];
+                leaf->products[i] = leaf->products[i - 1];
+            }
+            leaf->keys[pos] = code;
+            leaf->products[pos] = product;
+            leaf->count++;
+            size++;
+            return true;
+        }
 
-    while (!file.eof())
-    {
-        Product *newProduct = new Product;
-        file >> newProduct->code 
-             >> newProduct->name 
-             >> newProduct->price 
-             >> newProduct->discount 
-             >> newProduct->stock 
-             >> newProduct->category;
+        // Leaf is full: split it. Appending at the far right (the common case
+        // when loading sorted input) leaves the old leaf full instead of half
+        // empty, keeping sequential loads densely packed.
+        IndexLeaf *sibling = newLeaf();
+        int keep = (pos == INDEX_NODE_KEYS && !leaf->next) ? INDEX_NODE_KEYS : (INDEX_NODE_KEYS + 1) / 2;
 
-        if (file.fail())
+        int keys[INDEX_NODE_KEYS + 1];
+        Product *products[INDEX_NODE_KEYS + 1];
+        for (int i = 0, k = 0; i < INDEX_NODE_KEYS; i++)
         {
-            // Prevent memory leaks if read fails
-            delete newProduct;
-            break;
+            if (i == pos)
+            {
+                keys[k] = code;
+                products[k++] = product;
+            }
+            keys[k] = leaf->keys[i];
+            products[k++] = leaf->products[i];
+        }
+        if (pos == INDEX_NODE_KEYS)
+        {
+            keys[INDEX_NODE_KEYS] = code;
+            products[INDEX_NODE_KEYS] = product;
         }
 
-        newProduct->left = nullptr;
-        newProduct->right = nullptr;
+        leaf->count = keep;
+        for (int i = 0; i < keep; i++)
+        {
+            leaf->keys[i] = keys[i];
+            leaf->products[i] = products[i];
+        }
+        sibling->count = INDEX_NODE_KEYS + 1 - keep;
+        for (int i = 0; i < sibling->count; i++)
+        {
+            sibling->keys[i] = keys[keep + i];
+            sibling->products[i] = products[keep + i];
+        }
+        sibling->next = leaf->next;
+        leaf->next = sibling;
+        size++;
 
-        productRoot = addProductToTree(productRoot, newProduct);
+        insertIntoParent(path, slots, depth, sibling->keys[0], sibling);
+        return true;
     }
 
-    file.close();
-    cout << "Products loaded successfully.\n";
-}
-
-// ========== SAVE ALL PRODUCTS ==========
-void Shopping::saveAllProducts()
-{
-    ofstream file("products.txt");
-    if (!file)
+    // Builds the tree bottom-up from products already sorted by unique code.
+    // Nodes are filled evenly, so no searching or splitting is needed.
+    void bulkLoad(Product *const *products, int n)
     {
-        cout << "Error: Unable to save products to file.\n";
-        return;
+        destroy(root);
+        root = nullptr;
+        head = nullptr;
+        size = n;
+        if (n == 0) return;
+
+        vector<IndexNode *> level;
+        vector<int> lowKeys;
+        int leafCount = (n + INDEX_NODE_KEYS - 1) / INDEX_NODE_KEYS;
+        IndexLeaf *previous = nullptr;
+        for (int i = 0, start = 0; i < leafCount; i++)
+        {
+            int take = n / leafCount + (i < n % leafCount ? 1 : 0);
+            IndexLeaf *leaf = newLeaf();
+            leaf->count = take;
+            for (int k = 0; k < take; k++)
+            {
+                leaf->keys[k] = products[start + k]->code;
+                leaf->products[k] = products[start + k];
+            }
+            start += take;
+
+            if (previous) previous->next = leaf;
+            else head = leaf;
+            previous = leaf;
+            level.push_back(leaf);
+            lowKeys.push_back(leaf->keys[0]);
+        }
+
+        while (level.size() > 1)
+        {
+            int m = int(level.size());
+            int parentCount = (m + INDEX_NODE_KEYS) / (INDEX_NODE_KEYS + 1);
+            vector<IndexNode *> parents;
+            vector<int> parentLowKeys;
+            for (int i = 0, start = 0; i < parentCount; i++)
+            {
+                int take = m / parentCount + (i < m % parentCount ? 1 : 0);
+                IndexInner *inner = newInner();
+                inner->count = take - 1;
+                for (int k = 0; k < take; k++)
+                {
+                    inner->children[k] = level[start + k];
+                    if (k > 0) inner->keys[k - 1] = lowKeys[start + k];
+                }
+                parents.push_back(inner);
+                parentLowKeys.push_back(lowKeys[start]);
+                start += take;
+            }
+            level.swap(parents);
+            lowKeys.swap(parentLowKeys);
+        }
+        root = level[0];
     }
 
-    saveProductsToFile(productRoot, file);
-    file.close();
+    // Unlinks the product with this code and returns it (nullptr if absent)
+    Product *erase(int code)
+    {
+        if (!root) return nullptr;
 
-    cout << "Product data saved successfully.\n";
-}
+        IndexInner *path[INDEX_MAX_DEPTH];
+        int slots[INDEX_MAX_DEPTH];
+        int depth = 0;
+        IndexNode *node = root;
+        while (!node->leaf)
+        {
+            IndexInner *inner = static_cast<IndexInner *>(node);
+            path[depth] = inner;
+            slots[depth] = upperBound(inner, code);
+            node = inner->children[slots[depth]];
+            depth++;
+        }
 
-// ========== RECURSIVE HELPER TO SAVE TO FILE ==========
-void Shopping::saveProductsToFile(Product *root, ofstream &file)
-{
-    if (!root) return;
-    saveProductsToFile(root->left, file);
-    file << root->code << " " 
-         << root->name << " " 
-         << root->price << " " 
-         << root->discount << " "
-         << root->stock << " " 
-         << root->category << "\n";
-    saveProductsToFile(root->right, file);
-}
+        IndexLeaf *leaf = static_cast<IndexLeaf *>(node);
+        int pos = lowerBound(leaf, code);
+        if (pos == leaf->count || leaf->keys[pos] != code)
+            return nullptr;
 
-// ========== ADMIN METHODS ==========
+        Product *removed = leaf->products[pos];
+        for (int i = pos; i < leaf->count - 1; i++)
+        {
+            leaf->keys[i] = leaf->keys[i + 1];
+            leaf->products[i] = leaf->products[i + 1];
+        }
+        leaf->count--;
+        size--;
 
-// -------------- ADD PRODUCT --------------
-void Shopping::addProduct()
-{
-    Product *newProduct = new Product;
+        if (size == 0)
+        {
+            destroy(root);
+            root = nullptr;
+            head = nullptr;
+            return removed;
+        }
 
-    cout << "Enter Product Code: ";
-    cin >> newProduct->code;
+        rebalance(path, slots, depth, leaf);
+        return removed;
+    }
+};
+
+// ======================================
+// Category Index
+// ======================================
+// Category names are interned to small integer ids, and each id keeps a
+// posting list of its products sorted by code. Listing or discounting a
+// category touches only that category's products.
+class CategoryIndex
+{
+private:
+    unordered_map<string, int> ids;
+    vector<string> names;
+    vector<vector<Product *>> postings;
 
-    if (cin.fail() || newProduct->code <= 0)
+    static bool codeLess(const Product *a, const Product *b)
     {
-        cout << "Invalid Product Code! Code must be a positive integer.\n";
-        cin.clear();
-        cin.ignore(10000, '\n');
-        delete newProduct;
-        return;
+        return a->code < b->code;
     }
 
-    // Check for duplicate
-    if (findProduct(productRoot, newProduct->code) != nullptr)
+public:
+    // Id for a category name, creating one on first use
+    int intern(const string &category)
     {
-        cout << "Error: Product code already exists. Cannot add duplicate product.\n";
-        delete newProduct;
-        return;
+        unordered_map<string, int>::iterator found = ids.find(category);
+        if (found != ids.end())
+            return found->second;
+
+        int id = int(names.size());
+        ids[category] = id;
+        names.push_back(category);
+        postings.push_back(vector<Product *>());
+        return id;
     }
 
-    // Product Name
-    cout << "Enter Product Name: ";
-    cin.ignore();
-    getline(cin, newProduct->name);
+    // Id for a category name, or -1 if no product ever used it
+    int find(const string &category) const
+    {
+        unordered_map<string, int>::const_iterator found = ids.find(category);
+        return found == ids.end() ? -1 : found->second;
+    }
+
+    const string &name(int id) const { return names[id]; }
+
+    int categoryCount() const { return int(names.size()); }
+
+    // Products in a category, in code order
+    const vector<Product *> &productsIn(int id) const { return postings[id]; }
 
-    if (newProduct->name.empty())
+    void add(Product *product)
     {
-        cout << "Invalid Product Name! Name cannot be empty.\n";
-        delete newProduct;
-        return;
+        product->categoryId = intern(product->category);
+        vector<Product *> &list = postings[product->categoryId];
+
+        // Products usually arrive in code order (loads, new codes), so appending is the common case
+        if (list.empty() || list.back()->code < product->code)
+            list.push_back(product);
+        else
+            list.insert(lower_bound(list.begin(), list.end(), product, codeLess), product);
     }
 
-    // Price
-    cout << "Enter Product Price: ";
-    cin >> newProduct->price;
-    if (cin.fail() || newProduct->price <= 0)
+    void remove(const Product *product)
     {
-        cout << "Invalid Product Price! Price must be a positive number.\n";
-        cin.clear();
-        cin.ignore(10000, '\n');
-        delete newProduct;
-        return;
+        vector<Product *> &list = postings[product->categoryId];
+        vector<Product *>::iterator found = lower_bound(list.begin(), list.end(), product, codeLess);
+        if (found != list.end() && *found == product)
+            list.erase(found);
     }
+};
 
-    // Discount
-    cout << "Enter Discount Percentage (0-100): ";
-    cin >> newProduct->discount;
-    if (cin.fail() || newProduct->discount < 0 || newProduct->discount > 100)
+// ======================================
+// Name Index (trigram inverted index)
+// ======================================
+// Every lowercase three-character window of a product name maps to the
+// products containing it, sorted by code. A substring query intersects
+// the posting lists of its own trigrams and only checks the few
+// candidates that survive, instead of lowercasing every name in the
+// catalog.
+class NameIndex
+{
+private:
+    unordered_map<uint32_t, vector<Product *>> postings;
+
+    static bool codeLess(const Product *a, const Product *b)
     {
-        cout << "Invalid Discount! Must be between 0 and 100.\n";
-        cin.clear();
-        cin.ignore(10000, '\n');
-        delete newProduct;
-        return;
+        return a->code < b->code;
     }
 
-    // Stock
-    cout << "Enter Stock Quantity: ";
-    cin >> newProduct->stock;
-    if (cin.fail() || newProduct->stock < 0)
+    static uint32_t trigramAt(const string &text, size_t i)
     {
-        cout << "Invalid Stock Quantity! Stock cannot be negative.\n";
-        cin.clear();
-        cin.ignore(10000, '\n');
-        delete newProduct;
-        return;
+        return (uint32_t(uint8_t(text[i])) << 16) | (uint32_t(uint8_t(text[i + 1])) << 8)
+             | uint32_t(uint8_t(text[i + 2]));
     }
 
-    // Category
-    cout << "Enter Product Category: ";
-    cin.ignore();
-    getline(cin, newProduct->category);
-    if (newProduct->category.empty())
+    // Distinct trigrams of an already-lowercased string
+    static vector<uint32_t> trigrams(const string &text)
     {
-        cout << "Invalid Category! Category cannot be empty.\n";
-        delete newProduct;
-        return;
+        vector<uint32_t> result;
+        for (size_t i = 0; i + 3 <= text.size(); i++)
+            result.push_back(trigramAt(text, i));
+        sort(result.begin(), result.end());
+        result.erase(unique(result.begin(), result.end()), result.end());
+        return result;
     }
 
-    // Link pointers
-    newProduct->left = nullptr;
-    newProduct->right = nullptr;
+public:
+    static string normalize(string text)
+    {
+        transform(text.begin(), text.end(), text.begin(), ::tolower);
+        return text;
+    }
 
-    // Insert into BST
-    productRoot = addProductToTree(productRoot, newProduct);
+    // Queries shorter than a trigram cannot use the index
+    static bool canSearch(const string &normalizedQuery)
+    {
+        return normalizedQuery.size() >= 3;
+    }
 
-    cout << "Product added successfully!\n";
-    cout << "---------------------------\n";
-    cout << "Code: " << newProduct->code << "\n";
-    cout << "Name: " << newProduct->name << "\n";
-    cout << "Price: $" << newProduct->price << "\n";
-    cout << "Discount: " << newProduct->discount << "%\n";
-    cout << "Stock: " << newProduct->stock << "\n";
-    cout << "Category: " << newProduct->category << "\n";
+    void add(Product *product)
+    {
+        for (uint32_t trigram : trigrams(normalize(product->name)))
+        {
+            vector<Product *> &list = postings[trigram];
+            if (list.empty() || list.back()->code < product->code)
+                list.push_back(product);
+            else
+                list.insert(lower_bound(list.begin(), list.end(), product, codeLess), product);
+        }
+    }
 
-    // Log to file
-    ofstream logFile("ProductLog.txt", ios::app);
-    if (logFile.is_open())
-    {
-        logFile << "Product Added:\n";
-        logFile << "Code: " << newProduct->code << "\n";
-        logFile << "Name: " << newProduct->name << "\n";
-        logFile << "Price: $" << newProduct->price << "\n";
-        logFile << "Discount: " << newProduct->discount << "%\n";
-        logFile << "Stock: " << newProduct->stock << "\n";
-        logFile << "Category: " << newProduct->category << "\n";
-        logFile << "---------------------------------------\n";
-        logFile.close();
+    void remove(const Product *product)
+    {
+        for (uint32_t trigram : trigrams(normalize(product->name)))
+        {
+            unordered_map<uint32_t, vector<Product *>>::iterator found = postings.find(trigram);
+            if (found == postings.end()) continue;
+
+            vector<Product *> &list = found->second;
+            vector<Product *>::iterator slot = lower_bound(list.begin(), list.end(), product, codeLess);
+            if (slot != list.end() && *slot == product)
+                list.erase(slot);
+            if (list.empty())
+                postings.erase(found);
+        }
     }
-    else
+
+    // Products whose lowercase name contains the (lowercase, 3+ character)
+    // query, in code order
+    vector<Product *> search(const string &normalizedQuery) const
     {
-        cout << "Error: Unable to open log file for writing.\n";
+        vector<const vector<Product *> *> lists;
+        for (uint32_t trigram : trigrams(normalizedQuery))
+        {
+            unordered_map<uint32_t, vector<Product *>>::const_iterator found = postings.find(trigram);
+            if (found == postings.end())
+                return vector<Product *>();
+            lists.push_back(&found->second);
+        }
+
+        // Intersect starting from the rarest trigram
+        sort(lists.begin(), lists.end(),
+            [](const vector<Product *> *a, const vector<Product *> *b) { return a->size() < b->size(); });
+
+        vector<Product *> candidates = *lists[0];
+        for (size_t i = 1; i < lists.size() && !candidates.empty(); i++)
+        {
+            const vector<Product *> &list = *lists[i];
+            vector<Product *>::const_iterator cursor = list.begin();
+            size_t kept = 0;
+            for (Product *candidate : candidates)
+            {
+                cursor = lower_bound(cursor, list.end(), candidate, codeLess);
+                if (cursor == list.end()) break;
+                if (*cursor == candidate) candidates[kept++] = candidate;
+            }
+            candidates.resize(kept);
+        }
+
+        // Sharing every trigram does not guarantee a contiguous match; verify
+        vector<Product *> matches;
+        string productName;
+        for (Product *candidate : candidates)
+        {
+            productName.assign(candidate->name);
+            transform(productName.begin(), productName.end(), productName.begin(), ::tolower);
+            if (productName.find(normalizedQuery) != string::npos)
+                matches.push_back(candidate);
+        }
+        return matches;
     }
-}
+};
 
-// -------------- EDIT PRODUCT --------------
-void Shopping::editProduct()
+// ======================================
+// Price Index
+// ======================================
+// Two ordered sets keyed by (price, code): one on the list price and one
+// on the price after discount. A range query seeks to the lower bound and
+// walks forward until the upper bound, so it touches only the matching
+// products and yields them cheapest first.
+struct PriceEntry
 {
+    float price;
     int code;
-    cout << "Enter the Product Code to edit: ";
-    cin >> code;
+    Product *product;
 
-    Product *product = findProduct(productRoot, code);
-    if (!product)
+    bool operator<(const PriceEntry &other) const
     {
-        cout << "Product not found.\n";
-        return;
+        if (price != other.price)
+            return price < other.price;
+        return code < other.code;
     }
+};
 
-    cout << "\nEditing Product: " << product->name << "\n";
-    cout << "---------------------------------------\n";
-    cout << "Existing Details:\n";
-    cout << "Code: " << product->code << "\n";
-    cout << "Name: " << product->name << "\n";
-    cout << "Price: $" << product->price << "\n";
-    cout << "Discount: " << product->discount << "%\n";
-    cout << "Stock: " << product->stock << "\n";
-    cout << "Category: " << product->category << "\n";
-    cout << "---------------------------------------\n";
+class PriceIndex
+{
+private:
+    set<PriceEntry> byListPrice;
+    set<PriceEntry> byEffectivePrice;
 
-    cout << "Enter New Name (leave empty to keep existing): ";
-    cin.ignore();
-    string newName;
-    getline(cin, newName);
-    if (!newName.empty())
-        product->name = newName;
+public:
+    static float effectivePrice(const Product *product)
+    {
+        return product->price * (1 - product->discount / 100.0f);
+    }
 
-    cout << "Enter New Price (-1 to keep existing): ";
-    float newPrice;
-    cin >> newPrice;
-    if (newPrice >= 0)
-        product->price = newPrice;
+    void add(Product *product)
+    {
+        byListPrice.insert(PriceEntry{product->price, product->code, product});
+        byEffectivePrice.insert(PriceEntry{effectivePrice(product), product->code, product});
+    }
 
-    cout << "Enter New Discount Percentage (0-100, -1 to keep existing): ";
-    float newDiscount;
-    cin >> newDiscount;
-    if (newDiscount >= 0 && newDiscount <= 100)
-        product->discount = newDiscount;
+    // Must run before price or discount change, while the keys still match
+    void remove(const Product *product)
+    {
+        byListPrice.erase(PriceEntry{product->price, product->code, nullptr});
+        byEffectivePrice.erase(PriceEntry{effectivePrice(product), product->code, nullptr});
+    }
 
-    cout << "Enter New Stock Quantity (-1 to keep existing): ";
-    int newStock;
-    cin >> newStock;
-    if (newStock >= 0)
-        product->stock = newStock;
+    // Products priced within [minPrice, maxPrice], in price order (code
+    // order among equal prices)
+    template <typename Action>
+    void forEachInRange(float minPrice, float maxPrice, bool afterDiscount, Action action) const
+    {
+        const set<PriceEntry> &entries = afterDiscount ? byEffectivePrice : byListPrice;
+        set<PriceEntry>::const_iterator it = entries.lower_bound(PriceEntry{minPrice, INT32_MIN, nullptr});
+        for (; it != entries.end() && it->price <= maxPrice; ++it)
+            action(it->product);
+    }
+};
 
-    cout << "Enter New Category (leave empty to keep existing): ";
-    cin.ignore();
-    string newCategory;
-    getline(cin, newCategory);
-    if (!newCategory.empty())
-        product->category = newCategory;
+// ======================================
+// Stock Index
+// ======================================
+// Products ordered by (stock, code), so "stock below T" is a walk from
+// the front that stops at the first product at or above T. The number of
+// products under LOW_STOCK_THRESHOLD is kept as a running count.
+const int LOW_STOCK_THRESHOLD = 10;
 
-    cout << "Product updated successfully!\n";
-    cout << "---------------------------------------\n";
-    cout << "Updated Details:\n";
-    cout << "Code: " << product->code << "\n";
-    cout << "Name: " << product->name << "\n";
-    cout << "Price: $" << product->price << "\n";
-    cout << "Discount: " << product->discount << "%\n";
-    cout << "Stock: " << product->stock << "\n";
-    cout << "Category: " << product->category << "\n";
-    cout << "---------------------------------------\n";
+struct StockEntry
+{
+    int stock;
+    int code;
+    Product *product;
 
-    // Log
-    ofstream logFile("ProductLog.txt", ios::app);
-    if (logFile.is_open())
-    {
-        logFile << "Product Edited:\n";
-        logFile << "Code: " << product->code << "\n";
-        logFile << "Name: " << product->name << "\n";
-        logFile << "Price: $" << product->price << "\n";
-        logFile << "Discount: " << product->discount << "%\n";
-        logFile << "Stock: " << product->stock << "\n";
-        logFile << "Category: " << product->category << "\n";
-        logFile << "---------------------------------------\n";
-        logFile.close();
-    }
-    else
+    bool operator<(const StockEntry &other) const
     {
-        cout << "Error: Unable to open log file for writing.\n";
+        if (stock != other.stock)
+            return stock < other.stock;
+        return code < other.code;
     }
-}
+};
 
-// -------------- DELETE PRODUCT --------------
-void Shopping::deleteProduct()
+class StockIndex
 {
-    int code;
-    cout << "Enter the Product Code to delete: ";
-    cin >> code;
+private:
+    set<StockEntry> entries;
+    int lowStockCount;
 
-    // First check
-    Product *product = findProduct(productRoot, code);
-    if (!product)
+public:
+    StockIndex() : lowStockCount(0) {}
+
+    // Keyed on bookedStock, which changes only while the product is out
+    // of the index; the live counter may move on in between
+    void add(Product *product)
     {
-        cout << "Product not found.\n";
-        return;
+        entries.insert(StockEntry{product->bookedStock, product->code, product});
+        if (product->bookedStock < LOW_STOCK_THRESHOLD)
+            lowStockCount++;
     }
 
-    cout << "\nProduct Details:\n";
-    cout << "---------------------------------------\n";
-    cout << "Code: " << product->code << "\n";
-    cout << "Name: " << product->name << "\n";
-    cout << "Price: $" << product->price << "\n";
-    cout << "Discount: " << product->discount << "%\n";
-    cout << "Stock: " << product->stock << "\n";
-    cout << "Category: " << product->category << "\n";
-    cout << "---------------------------------------\n";
-
-    char confirm;
-    cout << "Are you sure you want to delete this product? (Y/N): ";
-    cin >> confirm;
-    if (tolower(confirm) != 'y')
+    void remove(const Product *product)
     {
-        cout << "Product deletion canceled.\n";
-        return;
+        if (entries.erase(StockEntry{product->bookedStock, product->code, nullptr})
+            && product->bookedStock < LOW_STOCK_THRESHOLD)
+            lowStockCount--;
     }
 
-    productRoot = deleteProductFromTree(productRoot, code);
-    cout << "Product deleted successfully!\n";
+    // Products under LOW_STOCK_THRESHOLD, in O(1)
+    int lowStock() const { return lowStockCount; }
 
-    // Log
-    ofstream logFile("ProductLog.txt", ios::app);
-    if (logFile.is_open())
+    // Product with the most stock (lowest code among ties), or nullptr if
+    // nothing is in stock
+    Product *mostStocked() const
     {
-        logFile << "Product Deleted:\n";
-        logFile << "Code: " << code << "\n";
-        logFile << "---------------------------------------\n";
-        logFile.close();
+        if (entries.empty() || entries.rbegin()->stock <= 0)
+            return nullptr;
+        return entries.lower_bound(StockEntry{entries.rbegin()->stock, INT32_MIN, nullptr})->product;
     }
-    else
+
+    // Products with stock below threshold, lowest stock first
+    template <typename Action>
+    void forEachBelow(int threshold, Action action) const
     {
-        cout << "Error: Unable to open log file for writing.\n";
+        for (set<StockEntry>::const_iterator it = entries.begin();
+             it != entries.end() && it->stock < threshold; ++it)
+            action(it->product);
     }
-}
+};
 
-// -------------- LIST ALL PRODUCTS --------------
-void Shopping::listProducts()
+// ======================================
+// Catalog Analytics
+// ======================================
+// Running totals behind the analytics dashboard: product count and the
+// estimated stock value, overall and per category id. Each product's
+// contribution is added when it is indexed and subtracted before any
+// field it depends on changes, so the dashboard never rescans the
+// catalog. Sums are kept in double so repeated add/subtract cycles do not
+// drift visibly.
+class CatalogAnalytics
 {
-    if (!productRoot)
+private:
+    int productCount;
+    double totalRevenue;
+    vector<int> categoryCounts;
+    vector<double> categoryRevenue;
+
+public:
+    CatalogAnalytics() : productCount(0), totalRevenue(0) {}
+
+    // Estimated revenue from selling a product's remaining (booked) stock
+    static float revenueOf(const Product *product)
     {
-        cout << "No products found in memory. Reloading from file...\n";
-        ifstream file("products.txt");
-        if (!file)
+        return (product->price * product->bookedStock) * (1 - product->discount / 100.0f);
+    }
+
+    // Category id must already be assigned by CategoryIndex::add
+    void add(const Product *product)
+    {
+        if (product->categoryId >= int(categoryCounts.size()))
         {
-            cout << "Error: No product data file found.\n";
-            return;
+            categoryCounts.resize(product->categoryId + 1, 0);
+            categoryRevenue.resize(product->categoryId + 1, 0);
         }
 
-        while (!file.eof())
-        {
-            Product *newProduct = new Product;
-            file >> newProduct->code 
-                 >> newProduct->name 
-                 >> newProduct->price 
-                 >> newProduct->discount 
-                 >> newProduct->stock 
-                 >> newProduct->category;
+        float revenue = revenueOf(product);
+        productCount++;
+        totalRevenue += revenue;
+        categoryCounts[product->categoryId]++;
+        categoryRevenue[product->categoryId] += revenue;
+    }
 
-            if (file.fail())
-            {
-                delete newProduct;
-                break;
-            }
+    void remove(const Product *product)
+    {
+        float revenue = revenueOf(product);
+        productCount--;
+        totalRevenue -= revenue;
+        categoryCounts[product->categoryId]--;
+        categoryRevenue[product->categoryId] -= revenue;
+
+        // Snap emptied totals back to exactly zero
+        if (productCount == 0)
+            totalRevenue = 0;
+        if (categoryCounts[product->categoryId] == 0)
+            categoryRevenue[product->categoryId] = 0;
+    }
 
-            newProduct->left = newProduct->right = nullptr;
-            productRoot = addProductToTree(productRoot, newProduct);
-        }
-        file.close();
+    int products() const { return productCount; }
+    double revenue() const { return totalRevenue; }
+
+    // Categories that currently hold products
+    int categoryCount(int id) const
+    {
+        return id < int(categoryCounts.size()) ? categoryCounts[id] : 0;
     }
 
-    if (!productRoot)
+    double categoryRevenueOf(int id) const
     {
-        cout << "No products available to list.\n";
-        return;
+        return id < int(categoryRevenue.size()) ? categoryRevenue[id] : 0;
     }
+};
 
-    cout << "===================================================================\n";
-    cout << "Code\tName\t\tPrice\tDiscount\tStock\tCategory\n";
-    cout << "===================================================================\n";
-    inOrderTraversal(productRoot);
-    cout << "===================================================================\n";
-}
+// ======================================
+// Binary Catalog Snapshot
+// ======================================
+// products.snap layout: a SnapshotHeader, then recordCount fixed-width
+// SnapshotRecords sorted by code, then a heap holding every name and
+// category back to back. Records point into the heap by offset, so the
+// file can be mapped and used without parsing. products.txt remains
+// the human-readable import/export format.
+const char SNAPSHOT_MAGIC[8] = {'S', 'M', 'S', 'N', 'A', 'P', '\r', '\n'};
+const uint32_t SNAPSHOT_VERSION = 1;
+
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t recordCount;
+    uint64_t heapSize;
+};
 
-// -------------- LIST PRODUCTS BY CATEGORY --------------
-void Shopping::listProductsByCategory()
+struct SnapshotRecord
 {
-    if (!productRoot)
-    {
-        cout << "No products available.\n";
-        return;
-    }
+    int32_t code;
+    float price;
+    float discount;
+    int32_t stock;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint32_t categoryOffset;
+    uint32_t categoryLength;
+};
 
-    cout << "Enter the category to list products: ";
-    cin.ignore();
+// ======================================
+// Product Journal (write-ahead log)
+// ======================================
+// Every inventory mutation is appended to products.journal as a small
+// checksummed record. Records are buffered and written with a single
+// write + fdatasync per commit, so the cost of persisting an operation
+// is proportional to what it changed. At checkpoint time the journal is
+// rotated into a numbered segment (products.journal.<n>), which is
+// deleted once the matching delta file is safely on disk.
+const char JOURNAL_MAGIC[8] = {'S', 'M', 'J', 'R', 'N', 'L', '\r', '\n'};
+const uint32_t JOURNAL_VERSION = 1;
+const size_t JOURNAL_GROUP_BYTES = 64 * 1024;          // force a commit past this much buffered data
+const off_t JOURNAL_CHECKPOINT_BYTES = 4 * 1024 * 1024; // checkpoint early past this size
+
+enum JournalRecordType
+{
+    JOURNAL_UPSERT = 1,   // full product record (add/edit)
+    JOURNAL_DELETE = 2,   // product removed
+    JOURNAL_STOCK = 3,    // stock set to a new value
+    JOURNAL_DISCOUNT = 4  // discount set to a new value
+};
+
+struct JournalEntry
+{
+    uint8_t type;
+    int32_t code;
+    float price;
+    float discount;
+    int32_t stock;
+    string name;
     string category;
-    getline(cin, category);
+};
 
-    cout << "\nProducts in Category: " << category << "\n";
-    cout << "===================================================================\n";
-    cout << "Code\tName\t\tPrice\tDiscount\tStock\n";
-    cout << "===================================================================\n";
+// Standard CRC-32 (IEEE 802.3), table-driven
+struct Crc32Table
+{
+    uint32_t entries[256];
 
-    // Lambda to traverse & filter
-    function<void(Product*)> inOrderTraversalByCategory = [&](Product *root)
+    Crc32Table()
     {
-        if (!root) return;
-        inOrderTraversalByCategory(root->left);
-        if (root->category == category)
+        for (uint32_t i = 0; i < 256; i++)
         {
-            cout << root->code << "\t" << root->name << "\t\t$" << root->price
-                 << "\t" << root->discount << "%\t\t" << root->stock << "\n";
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            entries[i] = c;
         }
-        inOrderTraversalByCategory(root->right);
-    };
+    }
+};
 
-    inOrderTraversalByCategory(productRoot);
+uint32_t crc32(const char *data, size_t length)
+{
+    static const Crc32Table table;
 
-    cout << "===================================================================\n";
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < length; i++)
+        crc = table.entries[(crc ^ uint8_t(data[i])) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
 
-    // Log
-    ofstream logFile("ProductLog.txt", ios::app);
-    if (logFile.is_open())
+// Writes the whole buffer, retrying short writes
+bool writeAll(int fd, const char *data, size_t length)
+{
+    while (length > 0)
     {
-        logFile << "Listed Products by Category: " << category << "\n";
-        logFile << "---------------------------------------\n";
-        logFile.close();
+        ssize_t written = ::write(fd, data, length);
+        if (written < 0) return false;
+        data += written;
+        length -= size_t(written);
     }
-    else
+    return true;
+}
+
+// Reads a whole file into memory; false if it cannot be opened
+bool readWholeFile(const string &path, string &contents)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    bool ok = fstat(fd, &info) == 0;
+    if (ok)
     {
-        cout << "Error: Unable to open log file for writing.\n";
+        contents.resize(size_t(info.st_size));
+        ok = info.st_size == 0 || pread(fd, &contents[0], contents.size(), 0) == ssize_t(contents.size());
     }
+    close(fd);
+    return ok;
 }
 
-// -------------- LOW STOCK ALERT --------------
-void Shopping::lowStockAlert()
+// Holds an flock() on a file for a scope. Processes sharing the catalog
+// share its other files too, and take the lock only around each access.
+// Closing the file also drops the lock, so release() comes first.
+class FileLock
 {
-    if (!productRoot)
+private:
+    int fd;
+
+    FileLock(const FileLock &) = delete;
+    FileLock &operator=(const FileLock &) = delete;
+
+public:
+    FileLock() : fd(-1) {}
+    FileLock(int file, int operation) : fd(-1) { acquire(file, operation); }
+    ~FileLock() { release(); }
+
+    // operation is LOCK_SH or LOCK_EX; waits for it
+    bool acquire(int file, int operation)
     {
-        cout << "No products available.\n";
-        return;
+        release();
+        int result;
+        while ((result = flock(file, operation)) != 0 && errno == EINTR) {}
+        if (result == 0)
+            fd = file;
+        return result == 0;
     }
 
-    int threshold;
-    cout << "Enter the stock threshold for alert: ";
-    cin >> threshold;
-
-    cout << "\nLow Stock Products (Stock < " << threshold << "):\n";
-    cout << "===================================================================\n";
-    cout << "Code\tName\t\tPrice\tDiscount\tStock\tCategory\n";
-    cout << "===================================================================\n";
-
-    function<void(Product*)> inOrderTraversalLowStock = [&](Product *root)
+    void release()
     {
-        if (!root) return;
-        inOrderTraversalLowStock(root->left);
-        if (root->stock < threshold)
-        {
-            cout << root->code << "\t" << root->name << "\t\t$" << root->price
-                 << "\t" << root->discount << "%\t\t" << root->stock
-                 << "\t" << root->category << "\n";
-        }
-        inOrderTraversalLowStock(root->right);
-    };
-
-    inOrderTraversalLowStock(productRoot);
+        if (fd >= 0)
+            flock(fd, LOCK_UN);
+        fd = -1;
+    }
 
-    cout << "===================================================================\n";
+    bool held() const { return fd >= 0; }
+};
 
-    // Log
-    ofstream logFile("ProductLog.txt", ios::app);
-    if (logFile.is_open())
-    {
-        logFile << "Generated Low Stock Alert (Threshold: " << threshold << "):\n";
-        logFile << "---------------------------------------\n";
-        logFile.close();
-    }
-    else
+class ProductJournal
+{
+private:
+    int fd;
+    string path;
+    string pending; // encoded records not yet written
+    off_t fileSize;
+    mutex syncLock;               // leaf lock: fdatasync and swapping fd
+    atomic<off_t> writtenSize;    // file size after the last write
+    off_t syncedSize;             // file size covered by the last sync
+
+    template <typename T>
+    static void put(string &out, T value)
     {
-        cout << "Error: Unable to open log file for writing.\n";
+        out.append(reinterpret_cast<const char *>(&value), sizeof(value));
     }
-}
 
-// -------------- SORT PRODUCTS BY FIELD --------------
-void Shopping::sortProductsByField(int field)
-{
-    if (!productRoot)
+    static void putString(string &out, const string &value)
     {
-        cout << "No products available to sort.\n";
-        return;
+        put(out, uint32_t(value.size()));
+        out += value;
     }
 
-    // Collect all products into a vector
-    vector<Product*> products;
-    function<void(Product*)> collectProducts = [&](Product *root)
+    template <typename T>
+    static bool get(const char *&cursor, const char *end, T &value)
     {
-        if (!root) return;
-        collectProducts(root->left);
-        products.push_back(root);
-        collectProducts(root->right);
-    };
-    collectProducts(productRoot);
+        if (size_t(end - cursor) < sizeof(T)) return false;
+        memcpy(&value, cursor, sizeof(T));
+        cursor += sizeof(T);
+        return true;
+    }
 
-    // Sort based on field
-    switch (field)
+    static bool getString(const char *&cursor, const char *end, string &value)
     {
-    case 1: // Name
-        sort(products.begin(), products.end(), 
-            [](Product *a, Product *b){ return a->name < b->name; });
-        break;
-    case 2: // Price
-        sort(products.begin(), products.end(), 
-            [](Product *a, Product *b){ return a->price < b->price; });
-        break;
-    case 3: // Stock
-        sort(products.begin(), products.end(), 
-            [](Product *a, Product *b){ return a->stock < b->stock; });
-        break;
-    default:
-        cout << "Invalid sorting field. Please choose 1 (Name), 2 (Price), or 3 (Stock).\n";
-        return;
+        uint32_t length;
+        if (!get(cursor, end, length) || size_t(end - cursor) < length) return false;
+        value.assign(cursor, length);
+        cursor += length;
+        return true;
     }
 
-    // Display sorted
-    cout << "\nSorted Products:\n";
-    cout << "===================================================================\n";
-    cout << "Code\tName\t\tPrice\tDiscount\tStock\tCategory\n";
-    cout << "===================================================================\n";
-
-    for (auto product : products)
+    static bool headerValid(const string &contents)
     {
-        cout << product->code << "\t" << product->name << "\t\t$" << product->price
-             << "\t" << product->discount << "%\t\t" << product->stock
-             << "\t" << product->category << "\n";
+        uint32_t version = 0;
+        if (contents.size() < size_t(headerSize())
+            || memcmp(contents.data(), JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0)
+            return false;
+        memcpy(&version, contents.data() + sizeof(JOURNAL_MAGIC), sizeof(version));
+        return version == JOURNAL_VERSION;
     }
-    cout << "===================================================================\n";
 
-    // Log
-    ofstream logFile("ProductLog.txt", ios::app);
-    if (logFile.is_open())
+    // Applies every intact record after the header; returns the length
+    // of the valid prefix so a torn tail can be cut off
+    template <typename Apply>
+    static size_t replayContents(const string &contents, Apply apply)
     {
-        logFile << "Sorted Products by Field (" << field << "):\n";
-        for (auto product : products)
+        const char *cursor = contents.data() + headerSize();
+        const char *end = contents.data() + contents.size();
+        const char *lastGood = cursor;
+        while (cursor < end)
         {
-            logFile << "Code: " << product->code
-                    << ", Name: " << product->name
-                    << ", Price: $" << product->price
-                    << ", Stock: " << product->stock
-                    << ", Category: " << product->category << "\n";
+            uint32_t length, checksum;
+            if (!get(cursor, end, length) || !get(cursor, end, checksum) || size_t(end - cursor) < length)
+                break;
+            if (crc32(cursor, length) != checksum)
+                break;
+
+            const char *payloadEnd = cursor + length;
+            JournalEntry entry;
+            bool decoded = get(cursor, payloadEnd, entry.type) && get(cursor, payloadEnd, entry.code);
+            if (decoded && entry.type == JOURNAL_UPSERT)
+            {
+                decoded = get(cursor, payloadEnd, entry.price) && get(cursor, payloadEnd, entry.discount)
+                       && get(cursor, payloadEnd, entry.stock) && getString(cursor, payloadEnd, entry.name)
+                       && getString(cursor, payloadEnd, entry.category);
+            }
+            else if (decoded && entry.type == JOURNAL_STOCK)
+                decoded = get(cursor, payloadEnd, entry.stock);
+            else if (decoded && entry.type == JOURNAL_DISCOUNT)
+                decoded = get(cursor, payloadEnd, entry.discount);
+            else if (decoded && entry.type != JOURNAL_DELETE)
+                decoded = false;
+            if (!decoded)
+                break;
+
+            apply(entry);
+            cursor = payloadEnd;
+            lastGood = cursor;
         }
-        logFile << "---------------------------------------\n";
-        logFile.close();
+        return size_t(lastGood - contents.data());
     }
-    else
+
+    // Frames a payload as [length][crc32][payload] and queues it
+    void append(const string &payload)
     {
-        cout << "Error: Unable to open log file for writing.\n";
+        put(pending, uint32_t(payload.size()));
+        put(pending, crc32(payload.data(), payload.size()));
+        pending += payload;
+        if (pending.size() >= JOURNAL_GROUP_BYTES)
+            commit();
     }
-}
-
-// -------------- CREATE PROMOTION --------------
-void Shopping::createPromotion()
-{
-    int promotionType;
-    cout << "Create Promotion:\n";
-    cout << "1) Discount on a Specific Product\n";
-    cout << "2) Discount on a Category\n";
-    cout << "3) General Discount on All Products\n";
-    cout << "Enter your choice: ";
-    cin >> promotionType;
 
-    if (promotionType < 1 || promotionType > 3)
+    bool writeHeader()
     {
-        cout << "Invalid choice. Please select 1, 2, or 3.\n";
-        return;
+        string header(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+        put(header, JOURNAL_VERSION);
+        if (!writeAll(fd, header.data(), header.size())) return false;
+        fileSize = off_t(header.size());
+        writtenSize = fileSize;
+        syncedSize = fileSize;
+        return true;
     }
 
-    ofstream logFile("PromotionLog.txt", ios::app);
-    if (!logFile.is_open())
+public:
+    ProductJournal() : fd(-1), fileSize(0), writtenSize(0), syncedSize(0) {}
+    ~ProductJournal()
     {
-        cout << "Error: Unable to open promotion log file.\n";
-        return;
+        commit();
+        if (fd >= 0) close(fd);
     }
 
-    logFile << "New Promotion Created:\n";
+    static off_t headerSize() { return off_t(sizeof(JOURNAL_MAGIC) + sizeof(uint32_t)); }
 
-    switch (promotionType)
-    {
-    case 1:
+    off_t size() const { return fileSize + off_t(pending.size()); }
+
+    // Opens (or creates) the journal. Existing records are replayed
+    // through apply; a torn or corrupt tail is cut off.
+    template <typename Apply>
+    bool open(const string &journalPath, bool replay, Apply apply)
     {
-        // Specific Product
-        int code;
-        float discount;
-        cout << "Enter Product Code: ";
-        cin >> code;
-        cout << "Enter Discount Percentage (0-100): ";
-        cin >> discount;
+        path = journalPath;
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+        if (fd < 0) return false;
 
-        if (discount < 0 || discount > 100)
+        string contents;
+        if (!readWholeFile(path, contents)) return false;
+
+        if (!replay || !headerValid(contents))
         {
-            cout << "Invalid discount percentage. Must be between 0 and 100.\n";
-            logFile.close();
-            return;
+            if (ftruncate(fd, 0) != 0) return false;
+            return writeHeader() && fdatasync(fd) == 0;
         }
 
-        Product *product = findProduct(productRoot, code);
-        if (!product)
+        fileSize = off_t(replayContents(contents, apply));
+        if (fileSize != off_t(contents.size()))
         {
-            cout << "Product not found.\n";
-            logFile.close();
-            return;
+            cout << "Warning: Discarding a damaged tail of the product journal.\n";
+            if (ftruncate(fd, fileSize) != 0) return false;
         }
+        writtenSize = fileSize;
+        syncedSize = fileSize;
+        return true;
+    }
 
-        product->discount = discount;
-        cout << "Discount of " << discount << "% applied to product: " << product->name << "\n";
-        logFile << "Promotion Type: Specific Product\n";
-        logFile << "Product Code: " << product->code << ", Name: " << product->name
-                << ", Discount: " << discount << "%\n";
-        break;
+    // Replays a rotated segment left behind by an interrupted checkpoint
+    template <typename Apply>
+    static bool replayFile(const string &segmentPath, Apply apply)
+    {
+        string contents;
+        if (!readWholeFile(segmentPath, contents) || !headerValid(contents))
+            return false;
+        replayContents(contents, apply);
+        return true;
     }
-    case 2:
+
+    void logUpsert(const Product *product)
     {
-        // Category
-        string category;
-        float discount;
-        cout << "Enter Category: ";
-        cin.ignore();
-        getline(cin, category);
-        cout << "Enter Discount Percentage (0-100): ";
-        cin >> discount;
-        if (discount < 0 || discount > 100)
-        {
-            cout << "Invalid discount percentage. Must be between 0 and 100.\n";
-            logFile.close();
-            return;
-        }
+        string payload;
+        put(payload, uint8_t(JOURNAL_UPSERT));
+        put(payload, int32_t(product->code));
+        put(payload, product->price);
+        put(payload, product->discount);
+        put(payload, int32_t(shelfStock(*product)));
+        putString(payload, product->name);
+        putString(payload, product->category);
+        append(payload);
+    }
 
-        function<void(Product*)> applyCategoryDiscount = [&](Product *root)
-        {
-            if (!root) return;
-            applyCategoryDiscount(root->left);
-            if (root->category == category)
-            {
-                root->discount = discount;
-                cout << "Discount of " << discount << "% applied to product: " << root->name << "\n";
-            }
-            applyCategoryDiscount(root->right);
-        };
-        applyCategoryDiscount(productRoot);
+    void logDelete(int code)
+    {
+        string payload;
+        put(payload, uint8_t(JOURNAL_DELETE));
+        put(payload, int32_t(code));
+        append(payload);
+    }
 
-        logFile << "Promotion Type: Category Discount\n";
-        logFile << "Category: " << category << ", Discount: " << discount << "%\n";
-        break;
+    void logStock(int code, int stock)
+    {
+        string payload;
+        put(payload, uint8_t(JOURNAL_STOCK));
+        put(payload, int32_t(code));
+        put(payload, int32_t(stock));
+        append(payload);
     }
-    case 3:
+
+    void logDiscount(int code, float discount)
     {
-        // General discount
-        float discount;
-        cout << "Enter Discount Percentage (0-100): ";
-        cin >> discount;
-        if (discount < 0 || discount > 100)
+        string payload;
+        put(payload, uint8_t(JOURNAL_DISCOUNT));
+        put(payload, int32_t(code));
+        put(payload, discount);
+        append(payload);
+    }
+
+    // Writes everything queued so far with one write and no sync. Callers
+    // hold the lock that orders the records, so they reach the file in
+    // the order they were queued.
+    bool write()
+    {
+        if (pending.empty() || fd < 0) return true;
+        if (!writeAll(fd, pending.data(), pending.size()))
         {
-            cout << "Invalid discount percentage. Must be between 0 and 100.\n";
-            logFile.close();
-            return;
+            cout << "Error: Unable to write the product journal.\n";
+            return false;
         }
+        fileSize += off_t(pending.size());
+        writtenSize = fileSize;
+        pending.clear();
+        return true;
+    }
 
-        function<void(Product*)> applyGeneralDiscount = [&](Product *root)
+    // Makes everything written so far durable. It takes no other lock, so
+    // concurrent callers share syncs: a caller that waited behind a running
+    // fdatasync covers every write made meanwhile with the next one, and a
+    // caller whose writes are already covered returns at once.
+    bool sync()
+    {
+        off_t written = writtenSize;
+        lock_guard<mutex> guard(syncLock);
+        if (syncedSize >= written || fd < 0) return true;
+        off_t target = writtenSize;
+        if (fdatasync(fd) != 0)
         {
-            if (!root) return;
-            applyGeneralDiscount(root->left);
-            root->discount = discount;
-            cout << "Discount of " << discount << "% applied to product: " << root->name << "\n";
-            applyGeneralDiscount(root->right);
-        };
-        applyGeneralDiscount(productRoot);
-
-        logFile << "Promotion Type: General Discount\n";
-        logFile << "Discount: " << discount << "%\n";
-        break;
-    }
+            cout << "Error: Unable to sync the product journal.\n";
+            return false;
+        }
+        syncedSize = target;
+        return true;
     }
 
-    logFile << "---------------------------------------\n";
-    logFile.close();
-    cout << "Promotion created successfully!\n";
-}
-
-// -------------- VIEW ANALYTICS --------------
-void Shopping::viewAnalytics()
-{
-    if (!productRoot)
+    // Group commit: everything queued so far goes out in one write + sync
+    bool commit()
     {
-        cout << "No products available to analyze.\n";
-        return;
+        return write() && sync();
     }
 
-    int totalProducts = 0;
-    int lowStockCount = 0;
-    float totalRevenue = 0.0;
-
-    map<string, int> categoryCounts;
-    map<string, float> categoryRevenue;
-
-    Product *mostPopularProduct = nullptr;
-    int highestSales = 0;
+    // Moves the committed records aside as a segment and starts a fresh journal
+    bool rotate(const string &segmentPath)
+    {
+        if (fd < 0 || !commit()) return false;
+        lock_guard<mutex> guard(syncLock);
+        close(fd);
+        fd = -1;
+        if (rename(path.c_str(), segmentPath.c_str()) != 0) return false;
+
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_APPEND, 0644);
+        return fd >= 0 && writeHeader() && fdatasync(fd) == 0;
+    }
 
-    function<void(Product*)> calculateAnalytics = [&](Product *root)
+    // Drops all records once a snapshot covering them is safely on disk
+    bool reset()
     {
-        if (!root) return;
-        calculateAnalytics(root->left);
+        pending.clear();
+        lock_guard<mutex> guard(syncLock);
+        if (fd < 0) return false;
+        if (ftruncate(fd, 0) != 0) return false;
+        return writeHeader() && fdatasync(fd) == 0;
+    }
+};
 
-        totalProducts++;
-        if (root->stock < 10)
-            lowStockCount++;
+// Delta files share the snapshot layout, followed by the codes deleted
+// since the previous checkpoint: [uint32 deleteCount][int32 codes...]
+const char DELTA_MAGIC[8] = {'S', 'M', 'D', 'E', 'L', 'T', '\r', '\n'};
 
-        float productRevenue = (root->price * root->stock) * (1 - root->discount / 100.0f);
-        totalRevenue += productRevenue;
+string deltaPath(int sequence)
+{
+    return "products.delta." + to_string(sequence);
+}
 
-        categoryCounts[root->category]++;
-        categoryRevenue[root->category] += productRevenue;
+string journalSegmentPath(int sequence)
+{
+    return "products.journal." + to_string(sequence);
+}
 
-        if (root->stock > highestSales)
+// Sequence numbers of the delta files and journal segments on disk
+set<int> checkpointFileSequences()
+{
+    set<int> sequences;
+    DIR *dir = opendir(".");
+    if (!dir)
+        return sequences;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != nullptr)
+    {
+        int sequence;
+        char tail;
+        if (sscanf(entry->d_name, "products.delta.%d%c", &sequence, &tail) == 1
+            || sscanf(entry->d_name, "products.journal.%d%c", &sequence, &tail) == 1)
         {
-            highestSales = root->stock;
-            mostPopularProduct = root;
+            sequences.insert(sequence);
         }
+    }
+    closedir(dir);
+    return sequences;
+}
 
-        calculateAnalytics(root->right);
-    };
-    calculateAnalytics(productRoot);
-
-    cout << "\nAnalytics Dashboard\n";
-    cout << "========================================================\n";
-    cout << "Total Products in Inventory: " << totalProducts << "\n";
-    cout << "Total Revenue (Estimate): $" << totalRevenue << "\n";
-    cout << "Low Stock Products (Stock < 10): " << lowStockCount << "\n";
-    cout << "Most Popular Product: " 
-         << (mostPopularProduct ? mostPopularProduct->name : "N/A") << "\n";
-    cout << "========================================================\n";
+// A process taking over the catalog files writes its snapshot here first.
+// Once this file exists it supersedes every other catalog file on disk.
+const char *const HANDOFF_SNAPSHOT_PATH = "products.snap.new";
 
-    cout << "\nCategory-wise Product Counts:\n";
-    for (auto &cat : categoryCounts)
-        cout << "Category: " << cat.first << " - Products: " << cat.second << "\n";
+// Removes the files the handoff snapshot supersedes, then renames it over
+// products.snap. Startup calls this again if a handoff was cut short, so
+// the old journal is never replayed over the newer snapshot.
+bool finishCatalogHandoff()
+{
+    for (int sequence : checkpointFileSequences())
+    {
+        remove(deltaPath(sequence).c_str());
+        remove(journalSegmentPath(sequence).c_str());
+    }
+    if (remove("products.journal") != 0 && errno != ENOENT)
+        return false;
+    if (rename(HANDOFF_SNAPSHOT_PATH, "products.snap") != 0)
+        return false;
 
-    cout << "\nCategory-wise Revenue:\n";
-    for (auto &cat : categoryRevenue)
-        cout << "Category: " << cat.first << " - Revenue: $" << cat.second << "\n";
+    int dirFd = open(".", O_RDONLY);
+    if (dirFd >= 0)
+    {
+        fsync(dirFd);
+        close(dirFd);
+    }
+    return true;
+}
 
-    cout << "========================================================\n";
+// products.txt holds one product per line: code, name, price, discount,
+// stock and category separated by tabs. Backslashes, tabs and newlines in
+// the name and category are escaped, and prices are written with as many
+// digits as it takes to read back the same float, so an import restores
+// exactly what was exported.
+string escapeExportField(const string &text)
+{
+    string escaped;
+    escaped.reserve(text.size());
+    for (char c : text)
+    {
+        if (c == '\\') escaped += "\\\\";
+        else if (c == '\t') escaped += "\\t";
+        else if (c == '\n') escaped += "\\n";
+        else escaped += c;
+    }
+    return escaped;
+}
 
-    // Log analytics
-    ofstream logFile("AnalyticsLog.txt", ios::app);
-    if (logFile.is_open())
+bool unescapeExportField(const string &text, string &value)
+{
+    value.clear();
+    for (size_t i = 0; i < text.size(); i++)
     {
-        logFile << "Analytics Report:\n";
-        logFile << "Total Products: " << totalProducts << "\n";
-        logFile << "Total Revenue: $" << totalRevenue << "\n";
-        logFile << "Low Stock Products: " << lowStockCount << "\n";
-        if (mostPopularProduct)
+        if (text[i] != '\\')
         {
-            logFile << "Most Popular Product: " << mostPopularProduct->name
-                    << " (Stock: " << mostPopularProduct->stock << ")\n";
+            value += text[i];
+            continue;
         }
-        logFile << "\nCategory-wise Product Counts:\n";
-        for (auto &cat : categoryCounts)
-            logFile << "Category: " << cat.first << " - Products: " << cat.second << "\n";
-
-        logFile << "\nCategory-wise Revenue:\n";
-        for (auto &cat : categoryRevenue)
-            logFile << "Category: " << cat.first << " - Revenue: $" << cat.second << "\n";
-
-        logFile << "---------------------------------------\n";
-        logFile.close();
+        if (++i == text.size())
+            return false;
+        if (text[i] == '\\') value += '\\';
+        else if (text[i] == 't') value += '\t';
+        else if (text[i] == 'n') value += '\n';
+        else return false;
     }
-    else
+    return !value.empty();
+}
+
+string exportNumber(float value)
+{
+    char text[32];
+    for (int digits = 6; digits <= 9; digits++)
     {
-        cout << "Error: Unable to open analytics log file for writing.\n";
+        snprintf(text, sizeof(text), "%.*g", digits, value);
+        if (strtof(text, nullptr) == value)
+            break;
     }
+    return text;
 }
 
-// ========== BUYER METHODS ==========
+template <typename T>
+bool parseExportNumber(const string &text, T &value)
+{
+    istringstream in(text);
+    in >> value;
+    return !in.fail() && in.eof();
+}
 
-// -------------- REGISTER CUSTOMER --------------
-void Shopping::customerRegistration()
+// One line of the products.txt export
+void writeProductLine(ostream &out, const Product &product)
 {
-    string username, password;
-    cout << "Enter Username: ";
-    cin >> username;
-    cout << "Enter Password: ";
-    cin >> password;
+    out << product.code << '\t'
+        << escapeExportField(product.name) << '\t'
+        << exportNumber(product.price) << '\t'
+        << exportNumber(product.discount) << '\t'
+        << shelfStock(product) << '\t'
+        << escapeExportField(product.category) << "\n";
+}
 
-    // Optional check: if user file already exists
-    ifstream checkFile(username + ".txt");
-    if (checkFile.good())
+// Reads one line of products.txt. A line without tabs is in the older
+// space-separated format, whose fields hold no spaces and no escapes.
+bool parseProductLine(const string &line, Product &product)
+{
+    vector<string> fields;
+    bool tabbed = line.find('\t') != string::npos;
+    if (tabbed)
     {
-        cout << "User already exists. Please try logging in.\n";
-        return;
+        size_t start = 0;
+        size_t end;
+        while ((end = line.find('\t', start)) != string::npos)
+        {
+            fields.push_back(line.substr(start, end - start));
+            start = end + 1;
+        }
+        fields.push_back(line.substr(start));
     }
-    checkFile.close();
-
-    ofstream customerFile(username + ".txt");
-    if (!customerFile)
+    else
     {
-        cout << "Error creating customer file.\n";
-        return;
+        istringstream in(line);
+        string field;
+        while (in >> field)
+            fields.push_back(field);
     }
+    if (fields.size() != 6)
+        return false;
 
-    customerFile << username << "\n" << password << "\n";
-    customerFile.close();
-
-    // Create new Customer in memory
-    Customer *newCustomer = new Customer{username, password, 0, nullptr, nullptr, nullptr};
-    newCustomer->next = customerHead;
-    customerHead = newCustomer;
-
-    // Set as current
-    currentCustomer = newCustomer;
-
-    cout << "Registration successful. Welcome, " << username << "!\n";
-}
-
-// -------------- LOGIN CUSTOMER --------------
-void Shopping::customerLogin()
-{
-    string username, password;
-    cout << "Enter Username: ";
-    cin >> username;
-    cout << "Enter Password: ";
-    cin >> password;
-
-    ifstream customerFile(username + ".txt");
-    if (!customerFile)
-    {
-        cout << "Invalid username or password.\n";
-        return;
-    }
-
-    string storedUsername, storedPassword;
-    customerFile >> storedUsername >> storedPassword;
-    customerFile.close();
-
-    if (storedUsername == username && storedPassword == password)
+    int stock;
+    bool valid = parseExportNumber(fields[0], product.code)
+              && parseExportNumber(fields[2], product.price)
+              && parseExportNumber(fields[3], product.discount)
+              && parseExportNumber(fields[4], stock);
+    if (tabbed)
     {
-        // Create or find this user in the linked list
-        // For simplicity, we'll just create a new node each login
-        Customer *newCustomer = new Customer{username, password, 0, nullptr, nullptr, nullptr};
-        newCustomer->next = customerHead;
-        customerHead = newCustomer;
-
-        currentCustomer = newCustomer;
-
-        cout << "Login successful. Welcome, " << username << "!\n";
+        valid = valid && unescapeExportField(fields[1], product.name)
+                      && unescapeExportField(fields[5], product.category);
     }
     else
     {
-        cout << "Invalid username or password.\n";
+        product.name = fields[1];
+        product.category = fields[5];
     }
+    product.stock = stock;
+    return valid;
 }
 
-// -------------- PLACE ORDER --------------
-void Shopping::placeOrder()
+// Whether one file time is later than another, to the nanosecond, so an
+// export edited in the same second it was written still counts as edited
+bool laterThan(const struct timespec &a, const struct timespec &b)
+{
+    return a.tv_sec != b.tv_sec ? a.tv_sec > b.tv_sec : a.tv_nsec > b.tv_nsec;
+}
+
+// Rewrites the products.txt export. It is stamped with the snapshot's time,
+// so startup keeps loading the snapshot until someone edits the export.
+bool exportProducts(const vector<const Product *> &products)
 {
-    if (!currentCustomer)
+    ofstream file("products.txt.tmp");
+    for (const Product *product : products)
+        writeProductLine(file, *product);
+    file.close();
+    if (file.fail() || rename("products.txt.tmp", "products.txt") != 0)
     {
-        cout << "Please log in to place an order.\n";
-        return;
+        remove("products.txt.tmp");
+        return false;
     }
-    if (!cartHead)
+
+    struct stat snapInfo;
+    if (stat("products.snap", &snapInfo) == 0)
     {
-        cout << "Your cart is empty.\n";
-        return;
+        struct timespec times[2] = {snapInfo.st_atim, snapInfo.st_mtim};
+        utimensat(AT_FDCWD, "products.txt", times, 0);
     }
+    return true;
+}
+
+// Maps a snapshot or delta file and calls visit(record, heap) for each
+// record in code order. For delta files, deletedCodes receives the codes
+// removed since the previous checkpoint.
+template <typename Visit>
+bool readCatalogFile(const string &path, const char *magic, Visit visit, vector<int> *deletedCodes)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
 
-    float totalCost = 0.0f;
-    ofstream orderFile(currentCustomer->username + "_orders.txt", ios::app);
-    if (!orderFile)
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(SnapshotHeader))
     {
-        cout << "Error: Unable to save order history.\n";
-        return;
+        close(fd);
+        return false;
     }
 
-    cout << "\nFinalizing Order:\n";
-    cout << "===================================================================\n";
-    cout << "Code\tName\t\tPrice\tDiscount\tQuantity\tTotal\n";
-    cout << "===================================================================\n";
+    size_t fileSize = info.st_size;
+    void *mapped = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+        return false;
 
-    Product *temp = cartHead;
-    while (temp)
+    const char *base = static_cast<const char *>(mapped);
+    const SnapshotHeader *header = reinterpret_cast<const SnapshotHeader *>(base);
+    bool valid = memcmp(header->magic, magic, sizeof(SNAPSHOT_MAGIC)) == 0
+              && header->version == SNAPSHOT_VERSION;
+
+    // Each section is checked against what is left of the file before the
+    // next one is located, so no corrupt count can wrap a sum of sizes
+    size_t remaining = fileSize - sizeof(SnapshotHeader);
+    valid = valid && header->recordCount <= remaining / sizeof(SnapshotRecord);
+    if (valid)
+        remaining -= size_t(header->recordCount) * sizeof(SnapshotRecord);
+    valid = valid && header->heapSize <= remaining;
+
+    const SnapshotRecord *records = nullptr;
+    const char *heap = nullptr;
+    size_t bodySize = 0;
+    if (valid)
     {
-        float itemCost = temp->price * temp->stock * (1 - temp->discount / 100.0f);
-        totalCost += itemCost;
+        remaining -= size_t(header->heapSize);
+        bodySize = fileSize - remaining;
+        records = reinterpret_cast<const SnapshotRecord *>(base + sizeof(SnapshotHeader));
+        heap = base + sizeof(SnapshotHeader) + size_t(header->recordCount) * sizeof(SnapshotRecord);
+    }
 
-        // Deduct from main inventory
-        Product *product = findProduct(productRoot, temp->code);
-        if (product)
+    uint32_t deleteCount = 0;
+    if (valid && deletedCodes)
+    {
+        valid = remaining >= sizeof(deleteCount);
+        if (valid)
         {
-            product->stock -= temp->stock;
+            memcpy(&deleteCount, base + bodySize, sizeof(deleteCount));
+            remaining -= sizeof(deleteCount);
+            valid = remaining / sizeof(int32_t) == deleteCount && remaining % sizeof(int32_t) == 0;
         }
+    }
+    else if (valid)
+    {
+        valid = remaining == 0;
+    }
 
-        // Write to order file (for permanent record)
-        orderFile << temp->code << " " << temp->name << " " << temp->stock << " " << itemCost << "\n";
+    if (valid)
+        madvise(mapped, fileSize, MADV_SEQUENTIAL);
 
-        // Also store the order in the currentCustomer->orderHistory
-        Order *newOrder = new Order{temp->code, temp->name, temp->stock, itemCost, nullptr};
-        if (!currentCustomer->orderHistory)
-        {
-            currentCustomer->orderHistory = newOrder;
-        }
-        else
+    for (uint32_t i = 0; valid && i < header->recordCount; i++)
+    {
+        const SnapshotRecord &record = records[i];
+        if ((i > 0 && records[i - 1].code >= record.code)
+            || uint64_t(record.nameOffset) + record.nameLength > header->heapSize
+            || uint64_t(record.categoryOffset) + record.categoryLength > header->heapSize)
         {
-            // append to the end
-            Order *ordTemp = currentCustomer->orderHistory;
-            while (ordTemp->next) ordTemp = ordTemp->next;
-            ordTemp->next = newOrder;
+            valid = false;
+            break;
         }
+        visit(record, heap);
+    }
 
-        // Display
-        cout << temp->code << "\t" << temp->name << "\t\t$" << temp->price 
-             << "\t" << temp->discount << "%\t" << temp->stock 
-             << "\t$" << itemCost << "\n";
-
-        // Move to next cart item
-        Product *toDelete = temp;
-        temp = temp->left;  // 'left' is acting like 'next' in cart
-        delete toDelete;
+    if (valid && deletedCodes)
+    {
+        const char *codes = base + bodySize + sizeof(deleteCount);
+        deletedCodes->resize(deleteCount);
+        if (deleteCount > 0)
+            memcpy(deletedCodes->data(), codes, size_t(deleteCount) * sizeof(int32_t));
     }
-    cartHead = nullptr; // cart is now empty
-    orderFile.close();
 
-    cout << "===================================================================\n";
-    cout << "Total Cost: $" << totalCost << "\n";
-    cout << "===================================================================\n";
+    munmap(mapped, fileSize);
+    return valid;
 }
 
-// -------------- VIEW ORDER HISTORY --------------
-void Shopping::viewOrderHistory()
+// Writes products (sorted by code) in snapshot layout, appending the
+// deleted-code trailer when writing a delta. The file is synced and
+// renamed into place so readers never see a torn file.
+bool writeCatalogFile(const string &path, const char *magic, const vector<const Product *> &products,
+                      const vector<int> *deletedCodes)
 {
-    if (!currentCustomer)
+    vector<SnapshotRecord> records;
+    string heap;
+    records.reserve(products.size());
+
+    for (const Product *product : products)
     {
-        cout << "Please log in first.\n";
-        return;
+        SnapshotRecord record;
+        record.code = product->code;
+        record.price = product->price;
+        record.discount = product->discount;
+        record.stock = shelfStock(*product);
+        record.nameOffset = uint32_t(heap.size());
+        record.nameLength = uint32_t(product->name.size());
+        heap += product->name;
+        record.categoryOffset = uint32_t(heap.size());
+        record.categoryLength = uint32_t(product->category.size());
+        heap += product->category;
+        records.push_back(record);
     }
 
-    string fileName = currentCustomer->username + "_orders.txt";
-    ifstream orderFile(fileName);
-    if (!orderFile)
+    SnapshotHeader header;
+    memcpy(header.magic, magic, sizeof(SNAPSHOT_MAGIC));
+    header.version = SNAPSHOT_VERSION;
+    header.recordCount = uint32_t(records.size());
+    header.heapSize = heap.size();
+
+    string tempPath = path + ".tmp";
+    int fd = open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+
+    bool ok = writeAll(fd, reinterpret_cast<const char *>(&header), sizeof(header))
+           && writeAll(fd, reinterpret_cast<const char *>(records.data()), records.size() * sizeof(SnapshotRecord))
+           && writeAll(fd, heap.data(), heap.size());
+    if (ok && deletedCodes)
     {
-        cout << "No order history found for " << currentCustomer->username << ".\n";
-        return;
+        uint32_t deleteCount = uint32_t(deletedCodes->size());
+        ok = writeAll(fd, reinterpret_cast<const char *>(&deleteCount), sizeof(deleteCount))
+          && writeAll(fd, reinterpret_cast<const char *>(deletedCodes->data()), deletedCodes->size() * sizeof(int32_t));
     }
+    ok = fsync(fd) == 0 && ok;
+    close(fd);
 
-    cout << "\nOrder History for " << currentCustomer->username << ":\n";
-    cout << "===================================================================\n";
-    cout << "Product Code\tProduct Name\tQuantity\tTotal Cost\n";
-    cout << "===================================================================\n";
+    if (!ok || rename(tempPath.c_str(), path.c_str()) != 0)
+    {
+        remove(tempPath.c_str());
+        return false;
+    }
 
-    int code, quantity;
-    string productName;
-    float totalCost;
-    bool hasOrders = false;
+    // Make the rename itself durable before anything that depends on it is deleted
+    int dirFd = open(".", O_RDONLY);
+    if (dirFd >= 0)
+    {
+        fsync(dirFd);
+        close(dirFd);
+    }
+    return true;
+}
+
+// ======================================
+// Background Catalog Checkpointer
+// ======================================
+// The interactive thread hands over copies of the products that changed
+// since the last checkpoint. This thread writes them to a numbered delta
+// file, drops the journal segment the delta replaces, and once too many
+// deltas pile up merges them into a fresh products.snap, all without
+// touching the live catalog.
+const int CHECKPOINT_INTERVAL_SECONDS = 30;
+const size_t MAX_DELTA_FILES = 8;
+
+struct CheckpointBatch
+{
+    int sequence;
+    vector<Product> upserts; // copies of changed products, sorted by code
+    vector<int> deletes;     // codes removed since the last checkpoint
+};
 
-    while (orderFile >> code >> productName >> quantity >> totalCost)
+class CatalogCheckpointer
+{
+private:
+    thread worker;
+    mutex lock;
+    condition_variable wakeup;
+    deque<CheckpointBatch> queue;
+    vector<int> deltaSequences; // unmerged delta files on disk, ascending
+    bool stopping;
+
+    void run()
     {
-        if (orderFile.fail())
+        unique_lock<mutex> guard(lock);
+        while (true)
         {
-            cout << "Error reading order history. Please check the file format.\n";
-            break;
+            wakeup.wait(guard, [&] { return stopping || !queue.empty(); });
+            if (queue.empty())
+                return;
+
+            CheckpointBatch batch = move(queue.front());
+            queue.pop_front();
+            guard.unlock();
+
+            if (writeDelta(batch))
+            {
+                deltaSequences.push_back(batch.sequence);
+                if (deltaSequences.size() > MAX_DELTA_FILES)
+                    mergeDeltas();
+                else
+                    exportMerged();
+            }
+            else
+            {
+                // The journal segment is kept, so nothing is lost; startup replays it
+                cout << "Warning: Unable to write checkpoint " << batch.sequence << ".\n";
+            }
+
+            guard.lock();
         }
-        cout << code << "\t\t" << productName << "\t" << quantity << "\t\t$" << totalCost << "\n";
-        hasOrders = true;
     }
 
-    if (!hasOrders)
+    bool writeDelta(const CheckpointBatch &batch)
     {
-        cout << "No orders found for " << currentCustomer->username << ".\n";
-    }
-    cout << "===================================================================\n";
+        vector<const Product *> products;
+        products.reserve(batch.upserts.size());
+        for (const Product &product : batch.upserts)
+            products.push_back(&product);
 
-    orderFile.close();
-}
+        if (!writeCatalogFile(deltaPath(batch.sequence), DELTA_MAGIC, products, &batch.deletes))
+            return false;
 
-// -------------- ADD TO WISHLIST --------------
-void Shopping::addToWishlist(int code)
-{
-    if (!currentCustomer)
+        remove(journalSegmentPath(batch.sequence).c_str());
+        return true;
+    }
+
+    // products.snap with every delta on disk applied, in code order; the
+    // pointers refer into base and changed
+    bool readMerged(vector<Product> &base, map<int, Product> &changed, vector<const Product *> &merged)
     {
-        cout << "Please log in to add items to your wishlist.\n";
-        return;
+        bool loaded = readCatalogFile("products.snap", SNAPSHOT_MAGIC,
+            [&](const SnapshotRecord &record, const char *heap)
+            {
+                Product product;
+                product.code = record.code;
+                product.name.assign(heap + record.nameOffset, record.nameLength);
+                product.price = record.price;
+                product.discount = record.discount;
+                product.stock = record.stock;
+                product.category.assign(heap + record.categoryOffset, record.categoryLength);
+                product.left = nullptr;
+                base.push_back(product);
+            }, nullptr);
+        if (!loaded)
+            return false;
+
+        // Later deltas override earlier ones
+        set<int> deleted;
+        for (int sequence : deltaSequences)
+        {
+            vector<int> deletes;
+            bool ok = readCatalogFile(deltaPath(sequence), DELTA_MAGIC,
+                [&](const SnapshotRecord &record, const char *heap)
+                {
+                    Product &product = changed[record.code];
+                    product.code = record.code;
+                    product.name.assign(heap + record.nameOffset, record.nameLength);
+                    product.price = record.price;
+                    product.discount = record.discount;
+                    product.stock = record.stock;
+                    product.category.assign(heap + record.categoryOffset, record.categoryLength);
+                    product.left = nullptr;
+                    deleted.erase(record.code);
+                }, &deletes);
+            if (!ok)
+                return false;
+            for (int code : deletes)
+            {
+                changed.erase(code);
+                deleted.insert(code);
+            }
+        }
+
+        // Merge the sorted base with the sorted overrides
+        merged.reserve(base.size() + changed.size());
+        map<int, Product>::const_iterator next = changed.begin();
+        for (const Product &product : base)
+        {
+            while (next != changed.end() && next->first < product.code)
+                merged.push_back(&(next++)->second);
+            if (next != changed.end() && next->first == product.code)
+                merged.push_back(&(next++)->second);
+            else if (!deleted.count(product.code))
+                merged.push_back(&product);
+        }
+        for (; next != changed.end(); ++next)
+            merged.push_back(&next->second);
+        return true;
     }
 
-    Product *product = findProduct(productRoot, code);
-    if (!product)
+    // Brings the products.txt export up to date with the latest checkpoint
+    void exportMerged()
     {
-        cout << "Product not found.\n";
-        return;
+        vector<Product> base;
+        map<int, Product> changed;
+        vector<const Product *> merged;
+        if (!readMerged(base, changed, merged) || !exportProducts(merged))
+            cout << "Warning: Unable to export products.txt.\n";
     }
 
-    // Add a copy of the product to the wishlist linked list
-    Product *newWishlistItem = new Product{product->code, product->name, product->price, product->discount, product->stock, product->category, nullptr, nullptr};
-    newWishlistItem->left = currentCustomer->wishlist;
-    currentCustomer->wishlist = newWishlistItem;
+    // Folds every delta on disk into products.snap and the products.txt export
+    bool mergeDeltas()
+    {
+        vector<Product> base;
+        map<int, Product> changed;
+        vector<const Product *> merged;
+        if (!readMerged(base, changed, merged)
+            || !writeCatalogFile("products.snap", SNAPSHOT_MAGIC, merged, nullptr))
+            return false;
+        if (!exportProducts(merged))
+            cout << "Warning: Unable to export products.txt.\n";
+
+        // Oldest first, so whatever survives a crash is always a suffix
+        for (int sequence : deltaSequences)
+            remove(deltaPath(sequence).c_str());
+        deltaSequences.clear();
+        return true;
+    }
 
-    // Also append to wishlist file
-    ofstream wishlistFile(currentCustomer->username + "_wishlist.txt", ios::app);
-    wishlistFile << product->code << " " << product->name << " " << product->price << "\n";
-    wishlistFile.close();
+public:
+    CatalogCheckpointer() : stopping(false) {}
+    ~CatalogCheckpointer() { stop(); }
 
-    cout << "Product " << product->name << " added to wishlist.\n";
-}
+    void start(const vector<int> &existingDeltas)
+    {
+        deltaSequences = existingDeltas;
+        stopping = false;
+        worker = thread(&CatalogCheckpointer::run, this);
+    }
 
-// -------------- VIEW WISHLIST --------------
-void Shopping::viewWishlist()
-{
-    if (!currentCustomer)
+    void submit(CheckpointBatch &batch)
     {
-        cout << "Please log in first.\n";
-        return;
+        lock_guard<mutex> guard(lock);
+        queue.push_back(move(batch));
+        wakeup.notify_one();
     }
-    ifstream wishlistFile(currentCustomer->username + "_wishlist.txt");
-    if (!wishlistFile)
+
+    // Finishes queued checkpoints, then stops the thread
+    void stop()
     {
-        cout << "Your wishlist is empty.\n";
-        return;
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+            wakeup.notify_one();
+        }
+        if (worker.joinable())
+            worker.join();
     }
+};
 
-    cout << "\nWishlist for " << currentCustomer->username << ":\n";
-    cout << "===================================================================\n";
-    cout << "Product Code\tProduct Name\tPrice\n";
-    cout << "===================================================================\n";
+// ======================================
+// Shared Catalog (POSIX shared memory)
+// ======================================
+// Processes started in the same directory share one live catalog through a
+// POSIX shared-memory segment. The segment holds offsets, never pointers,
+// so every process may map it at a different address:
+//   [SharedCatalogHeader][SharedProduct slots][SharedChange feed][string heap]
+// Products sit in an open-addressing table keyed by code; names and
+// categories are appended to the heap. Stock counters are used in place, so
+// a reservation in one process is a compare-and-swap every other process
+// sees at once. Everything else is written under a process-shared robust
+// mutex, and each change puts the product's code on a ring that the other
+// processes poll to bring their own indexes up to date.
+//
+// The first process reads the catalog files and creates the segment; the
+// ones after it copy the records out of it instead. One process at a time,
+// the owner, writes the journal and checkpoints. When it exits or dies
+// another one takes over, and the last process to leave removes the
+// segment.
+const char SHARED_CATALOG_MAGIC[8] = {'S', 'M', 'S', 'H', 'A', 'R', 'E', 'D'};
+const uint32_t SHARED_CATALOG_VERSION = 2;
+const int SHARED_MAX_PROCESSES = 256;
+const uint32_t SHARED_FEED_SIZE = 1 << 16; // changes kept for processes to catch up on
+const uint32_t SHARED_MIN_SLOTS = 1 << 16;
+const uint64_t SHARED_MIN_HEAP_BYTES = 16 << 20;
+
+enum SharedSlotState : uint32_t
+{
+    SHARED_EMPTY,
+    SHARED_LIVE,
+    SHARED_DELETED // keeps its code, so a code always maps to the same slot
+};
+
+struct SharedCatalogHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t capacity;  // product slots, a power of two
+    uint32_t usedSlots; // live or deleted
+    uint32_t liveCount;
+    uint64_t slotsOffset;
+    uint64_t feedOffset;
+    uint64_t heapOffset;
+    uint64_t heapSize;
+    uint64_t heapUsed;
+    pthread_mutex_t lock; // process-shared and robust; guards all but the counters
+    int32_t owner;        // pid writing the catalog files, 0 for none
+    int32_t members[SHARED_MAX_PROCESSES]; // attached pids, 0 for a free entry
+    atomic<uint64_t> sequence; // changes announced so far
+};
+
+struct SharedProduct
+{
+    int32_t code;
+    uint32_t state;
+    atomic<int> stock;
+    atomic<int> held; // units in carts of any process
+    float price;
+    float discount;
+    uint32_t nameOffset, nameLength;
+    uint32_t categoryOffset, categoryLength;
+};
+
+// One announced change; sequence is 0 while the entry is being rewritten
+struct SharedChange
+{
+    atomic<uint64_t> sequence;
+    atomic<int32_t> code;
+    atomic<int32_t> pid;
+};
 
+// A product copied out of the segment
+struct SharedRecord
+{
     int code;
+    bool live;
     string name;
+    string category;
     float price;
-    while (wishlistFile >> code >> name >> price)
+    float discount;
+    atomic<int> *stock;
+    atomic<int> *held;
+};
+
+class SharedCatalog
+{
+private:
+    string name;
+    int lockFd; // catalog.lock, held while joining, creating and leaving
+    char *base;
+    size_t length;
+    SharedCatalogHeader *header;
+    SharedProduct *slots;
+    SharedChange *feed;
+    char *heap;
+    int32_t pid;
+
+    // A process that died holding the lock leaves it usable
+    class Guard
     {
-        cout << code << "\t\t" << name << "\t\t$" << price << "\n";
-    }
-    cout << "===================================================================\n";
+    private:
+        pthread_mutex_t *mutex;
 
-    wishlistFile.close();
-}
+    public:
+        explicit Guard(pthread_mutex_t *lock) : mutex(lock)
+        {
+            if (pthread_mutex_lock(mutex) == EOWNERDEAD)
+                pthread_mutex_consistent(mutex);
+        }
+        ~Guard() { pthread_mutex_unlock(mutex); }
+    };
 
-// -------------- ADD TO CART --------------
-void Shopping::addToCart(int code, int quantity)
-{
-    if (quantity <= 0)
+    static bool alive(int32_t process)
     {
-        cout << "Error: Quantity must be greater than 0.\n";
-        return;
+        return process > 0 && (kill(process, 0) == 0 || errno == EPERM);
     }
 
-    Product *product = findProduct(productRoot, code);
-    if (!product)
+    static size_t align(size_t offset) { return (offset + 63) & ~size_t(63); }
+
+    // The slot holding code, or the empty slot where it would go. The
+    // table is never more than 3/4 full, so the probe always ends.
+    SharedProduct *probe(int code) const
     {
-        cout << "Product not found.\n";
-        return;
+        uint32_t mask = header->capacity - 1;
+        for (uint32_t i = (uint32_t(code) * 2654435761u) & mask;; i = (i + 1) & mask)
+        {
+            if (slots[i].state == SHARED_EMPTY || slots[i].code == code)
+                return &slots[i];
+        }
     }
 
-    if (quantity > product->stock)
+    bool hasSlotFor(const SharedProduct *slot) const
     {
-        cout << "Error: Not enough stock available. Stock remaining: " << product->stock << "\n";
-        return;
+        return slot->state != SHARED_EMPTY || (header->usedSlots + 1) * 4 <= header->capacity * 3;
     }
 
-    // Reduce stock from main inventory right away
-    product->stock -= quantity;
+    // Heap bytes the slot's new strings need beyond the ones it has. An
+    // empty string keeps the current one.
+    static uint64_t extraBytes(const SharedProduct *slot, const string &name, const string &category)
+    {
+        return (name.size() > slot->nameLength ? name.size() : 0)
+             + (category.size() > slot->categoryLength ? category.size() : 0);
+    }
 
-    // If already in cart, update quantity
-    Product *temp = cartHead;
-    while (temp)
+    // Moves the strings of live products to the front of the heap, giving
+    // back the bytes of renamed and deleted products. With the lock held;
+    // readers copy strings out under it, so none sees them move.
+    void compactHeap()
     {
-        if (temp->code == code)
+        string packed;
+        packed.reserve(size_t(header->heapUsed));
+        for (uint32_t i = 0; i < header->capacity; i++)
         {
-            temp->stock += quantity; 
-            cout << "Updated quantity of " << temp->name << " in cart to " << temp->stock << ".\n";
-            return;
+            SharedProduct &slot = slots[i];
+            if (slot.state != SHARED_LIVE)
+            {
+                slot.nameLength = 0;
+                slot.categoryLength = 0;
+                continue;
+            }
+            uint32_t nameOffset = uint32_t(packed.size());
+            packed.append(heap + slot.nameOffset, slot.nameLength);
+            slot.nameOffset = nameOffset;
+            uint32_t categoryOffset = uint32_t(packed.size());
+            packed.append(heap + slot.categoryOffset, slot.categoryLength);
+            slot.categoryOffset = categoryOffset;
         }
-        temp = temp->left;
+        memcpy(heap, packed.data(), packed.size());
+        header->heapUsed = packed.size();
     }
 
-    // Otherwise, add a new node to cart
-    Product *cartItem = new Product{product->code, product->name, product->price, product->discount, quantity, product->category, nullptr, nullptr};
-    cartItem->left = cartHead;
-    cartHead = cartItem;
-
-    cout << "Added " << quantity << " units of " << product->name << " to the cart.\n";
-}
-
-// -------------- MODIFY CART --------------
-void Shopping::modifyCart()
-{
-    if (!cartHead)
+    // Whether the slot's new strings fit, compacting the heap once it is
+    // full. With the lock held.
+    bool reserveHeap(const SharedProduct *slot, const string &name, const string &category)
     {
-        cout << "Your cart is empty.\n";
-        return;
+        if (header->heapUsed + extraBytes(slot, name, category) <= header->heapSize)
+            return true;
+        compactHeap();
+        return header->heapUsed + extraBytes(slot, name, category) <= header->heapSize;
     }
 
-    int code, quantity;
-    cout << "Enter Product Code to modify: ";
-    cin >> code;
-
-    Product *cartItem = cartHead;
-    Product *prev = nullptr;
-    while (cartItem && cartItem->code != code)
+    // A string that fits in the slot's bytes is written over them; a
+    // longer one goes at the end of the heap. Room was reserved first.
+    void putString(const string &value, uint32_t &offset, uint32_t &size)
     {
-        prev = cartItem;
-        cartItem = cartItem->left;
+        if (value.size() > size)
+        {
+            offset = uint32_t(header->heapUsed);
+            header->heapUsed += value.size();
+        }
+        memmove(heap + offset, value.data(), value.size());
+        size = uint32_t(value.size());
     }
 
-    if (!cartItem)
+    // With the lock held
+    bool write(SharedProduct *slot, Product *product)
     {
-        cout << "Product not found in the cart.\n";
-        return;
+        if (!hasSlotFor(slot) || !reserveHeap(slot, product->name, product->category))
+            return false;
+        if (slot->state == SHARED_EMPTY)
+        {
+            slot->code = product->code;
+            header->usedSlots++;
+        }
+        putString(product->name, slot->nameOffset, slot->nameLength);
+        putString(product->category, slot->categoryOffset, slot->categoryLength);
+        slot->price = product->price;
+        slot->discount = product->discount;
+        if (slot->state != SHARED_LIVE)
+        {
+            slot->state = SHARED_LIVE;
+            header->liveCount++;
+        }
+
+        // From here on the product's stock and held units are the shared counters
+        if (!product->stock.attachedTo(&slot->stock))
+        {
+            slot->stock.store(product->stock);
+            product->stock.attach(&slot->stock);
+        }
+        if (!product->held.attachedTo(&slot->held))
+        {
+            slot->held.store(product->held);
+            product->held.attach(&slot->held);
+        }
+        return true;
     }
 
-    cout << "Enter New Quantity (0 to remove): ";
-    cin >> quantity;
-    if (quantity == 0)
+    void read(SharedProduct *slot, SharedRecord &record) const
     {
-        // remove
-        if (!prev)
-            cartHead = cartItem->left;
-        else
-            prev->left = cartItem->left;
+        record.live = slot->state == SHARED_LIVE;
+        record.name.assign(heap + slot->nameOffset, slot->nameLength);
+        record.category.assign(heap + slot->categoryOffset, slot->categoryLength);
+        record.price = slot->price;
+        record.discount = slot->discount;
+        record.stock = &slot->stock;
+        record.held = &slot->held;
+    }
 
-        cout << "Removed " << cartItem->name << " from the cart.\n";
-        delete cartItem;
+    // Forgets processes that died without leaving; returns how many are
+    // left. With the lock held.
+    int pruneMembers()
+    {
+        int count = 0;
+        for (int32_t &member : header->members)
+        {
+            if (member != 0 && !alive(member))
+                member = 0;
+            if (member != 0)
+                count++;
+        }
+        if (header->owner != 0 && !alive(header->owner))
+            header->owner = 0;
+        return count;
     }
-    else
+
+    bool map(int fd, size_t size)
     {
-        cartItem->stock = quantity;
-        cout << "Updated quantity of " << cartItem->name << " to " << quantity << ".\n";
+        void *mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED)
+            return false;
+        base = static_cast<char *>(mapped);
+        length = size;
+        header = reinterpret_cast<SharedCatalogHeader *>(base);
+        return true;
     }
-}
 
-// -------------- DISPLAY CART --------------
-void Shopping::displayCart()
-{
-    if (!cartHead)
+    void locate()
     {
-        cout << "Your cart is empty.\n";
-        return;
+        slots = reinterpret_cast<SharedProduct *>(base + header->slotsOffset);
+        feed = reinterpret_cast<SharedChange *>(base + header->feedOffset);
+        heap = base + header->heapOffset;
     }
 
-    cout << "Cart Items:\n";
-    cout << "===================================================================\n";
-    cout << "Code\tName\t\tPrice\tDiscount\tQuantity\n";
-    cout << "===================================================================\n";
+    void unmap()
+    {
+        if (base)
+            munmap(base, length);
+        base = nullptr;
+        header = nullptr;
+    }
 
-    Product *temp = cartHead;
-    while (temp)
+public:
+    SharedCatalog()
+        : lockFd(-1), base(nullptr), length(0), header(nullptr), slots(nullptr), feed(nullptr),
+          heap(nullptr), pid(int32_t(getpid()))
     {
-        cout << temp->code << "\t" << temp->name << "\t\t$" << temp->price 
-             << "\t" << temp->discount << "%\t" << temp->stock << "\n";
-        temp = temp->left;
+        // One segment per working directory, like the catalog files
+        struct stat info;
+        if (stat(".", &info) == 0)
+            name = "/supermarket." + to_string(uint64_t(info.st_dev)) + "." + to_string(uint64_t(info.st_ino));
     }
-    cout << "===================================================================\n";
-}
 
-// -------------- SEARCH BY NAME --------------
-void Shopping::searchProductByName(string name)
-{
-    // to lowercase
-    transform(name.begin(), name.end(), name.begin(), ::tolower);
-    bool found = false;
+    ~SharedCatalog()
+    {
+        unmap();
+        if (lockFd >= 0)
+            close(lockFd);
+    }
 
-    cout << "Products matching the name '" << name << "':\n";
-    cout << "===================================================================\n";
-    cout << "Code\tName\t\tPrice\tDiscount\tStock\tCategory\n";
-    cout << "===================================================================\n";
+    bool attached() const { return header != nullptr; }
 
-    function<void(Product*)> searchByName = [&](Product *root)
+    // Serializes startup and exit across processes
+    void beginStartup()
     {
-        if (!root) return;
-        searchByName(root->left);
+        if (lockFd < 0)
+            lockFd = ::open("catalog.lock", O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (lockFd >= 0)
+            while (flock(lockFd, LOCK_EX) != 0 && errno == EINTR) {}
+    }
 
-        // Lowercase product name for matching
-        string productName = root->name;
-        transform(productName.begin(), productName.end(), productName.begin(), ::tolower);
+    void endStartup()
+    {
+        if (lockFd >= 0)
+            flock(lockFd, LOCK_UN);
+    }
 
-        if (productName.find(name) != string::npos)
+    // Attaches to the segment of a process that is still running. A
+    // segment left behind by processes that all died is removed, so the
+    // catalog is read from its files again. Between beginStartup and
+    // endStartup.
+    bool join()
+    {
+        if (name.empty())
+            return false;
+        int fd = shm_open(name.c_str(), O_RDWR, 0600);
+        struct stat info;
+        if (fd < 0)
+            return false;
+        if (fstat(fd, &info) != 0 || size_t(info.st_size) < sizeof(SharedCatalogHeader)
+            || !map(fd, size_t(info.st_size)))
         {
-            found = true;
-            cout << root->code << "\t" << root->name << "\t\t$" << root->price 
-                 << "\t" << root->discount << "%\t" << root->stock 
-                 << "\t" << root->category << "\n";
+            close(fd);
+            shm_unlink(name.c_str());
+            return false;
         }
-        searchByName(root->right);
-    };
-    searchByName(productRoot);
 
-    if (!found)
-        cout << "No products found matching '" << name << "'.\n";
+        int running = 0;
+        bool joined = false;
+        if (memcmp(header->magic, SHARED_CATALOG_MAGIC, sizeof(SHARED_CATALOG_MAGIC)) == 0
+            && header->version == SHARED_CATALOG_VERSION)
+        {
+            Guard guard(&header->lock);
+            running = pruneMembers();
+            for (int32_t &member : header->members)
+            {
+                if (running > 0 && member == 0)
+                {
+                    member = pid;
+                    joined = true;
+                    break;
+                }
+            }
+        }
 
-    cout << "===================================================================\n";
-}
+        if (!joined)
+        {
+            // A catalog that is in use but has no room for another process
+            // is left alone; create() then fails and this one runs unshared
+            unmap();
+            if (running == 0)
+                shm_unlink(name.c_str());
+            return false;
+        }
+        locate();
+        return true;
+    }
 
-// -------------- SEARCH BY PRICE RANGE --------------
-void Shopping::searchProductByPriceRange(float minPrice, float maxPrice)
+    // Creates the segment from the loaded catalog, with room for the
+    // catalog to double, and attaches each product's stock to its shared
+    // counter. This process becomes the owner. Between beginStartup and
+    // endStartup.
+    bool create(const vector<Product *> &products)
+    {
+        if (name.empty())
+            return false;
+        uint64_t text = 0;
+        for (const Product *product : products)
+            text += product->name.size() + product->category.size();
+        uint32_t capacity = SHARED_MIN_SLOTS;
+        while (capacity < 2 * products.size())
+            capacity *= 2;
+
+        uint64_t slotsOffset = align(sizeof(SharedCatalogHeader));
+        uint64_t feedOffset = align(slotsOffset + uint64_t(capacity) * sizeof(SharedProduct));
+        uint64_t heapOffset = align(feedOffset + SHARED_FEED_SIZE * sizeof(SharedChange));
+        uint64_t heapSize = max(SHARED_MIN_HEAP_BYTES, 4 * text);
+        size_t size = size_t(heapOffset + heapSize);
+
+        int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd < 0)
+            return false;
+        if (ftruncate(fd, off_t(size)) != 0 || !map(fd, size))
+        {
+            close(fd);
+            shm_unlink(name.c_str());
+            return false;
+        }
+
+        // The new segment is zero-filled: every slot is empty and every
+        // counter and feed entry is 0
+        header->capacity = capacity;
+        header->slotsOffset = slotsOffset;
+        header->feedOffset = feedOffset;
+        header->heapOffset = heapOffset;
+        header->heapSize = heapSize;
+        locate();
+
+        pthread_mutexattr_t attributes;
+        pthread_mutexattr_init(&attributes);
+        pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST);
+        pthread_mutex_init(&header->lock, &attributes);
+        pthread_mutexattr_destroy(&attributes);
+
+        for (Product *product : products)
+        {
+            if (!write(probe(product->code), product))
+            {
+                for (Product *written : products)
+                {
+                    written->stock.detach();
+                    written->held.detach();
+                }
+                unmap();
+                shm_unlink(name.c_str());
+                return false;
+            }
+        }
+
+        header->owner = pid;
+        header->members[0] = pid;
+        header->version = SHARED_CATALOG_VERSION;
+        memcpy(header->magic, SHARED_CATALOG_MAGIC, sizeof(SHARED_CATALOG_MAGIC));
+        return true;
+    }
+
+    // Detaches from the catalog; the last process out removes it. Between
+    // beginStartup and endStartup, so no process joins while the last one
+    // saves what is left. Stock counters stay mapped until destruction.
+    void leave()
+    {
+        if (!header)
+            return;
+        int remaining;
+        {
+            Guard guard(&header->lock);
+            for (int32_t &member : header->members)
+            {
+                if (member == pid)
+                    member = 0;
+            }
+            if (header->owner == pid)
+                header->owner = 0;
+            remaining = pruneMembers();
+        }
+        if (remaining == 0)
+            shm_unlink(name.c_str());
+    }
+
+    // Whether a product can still be added or given this name and
+    // category; an empty one is kept as it is
+    bool hasRoom(int code, const string &name, const string &category)
+    {
+        if (!header)
+            return true;
+        Guard guard(&header->lock);
+        SharedProduct *slot = probe(code);
+        return hasSlotFor(slot) && reserveHeap(slot, name, category);
+    }
+
+    // Publishes a product added or edited in this process; its stock
+    // becomes the shared counter
+    bool store(Product *product)
+    {
+        if (!header)
+            return true;
+        bool stored;
+        {
+            Guard guard(&header->lock);
+            stored = write(probe(product->code), product);
+        }
+        announce(product->code);
+        return stored;
+    }
+
+    void erase(int code)
+    {
+        if (!header)
+            return;
+        {
+            Guard guard(&header->lock);
+            SharedProduct *slot = probe(code);
+            if (slot->state == SHARED_LIVE)
+            {
+                slot->state = SHARED_DELETED;
+                header->liveCount--;
+            }
+        }
+        announce(code);
+    }
+
+    // Tells the other processes that the product changed
+    void announce(int code)
+    {
+        if (!header)
+            return;
+        uint64_t sequence = header->sequence.fetch_add(1) + 1;
+        SharedChange &change = feed[sequence % SHARED_FEED_SIZE];
+        change.sequence.store(0, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        change.code.store(code, memory_order_relaxed);
+        change.pid.store(pid, memory_order_relaxed);
+        change.sequence.store(sequence, memory_order_release);
+    }
+
+    uint64_t sequence() const { return header ? header->sequence.load(memory_order_acquire) : 0; }
+
+    // Collects the codes other processes announced after seen and moves
+    // seen past them. Stops early at an entry still being written, setting
+    // stalled. Returns false if the feed has already overwritten changes
+    // this process had not seen; only a full copy can catch up then.
+    bool changesSince(uint64_t &seen, vector<int> &codes, bool &stalled)
+    {
+        stalled = false;
+        uint64_t last = sequence();
+        if (last - seen > SHARED_FEED_SIZE)
+            return false;
+        for (uint64_t next = seen + 1; next <= last; next++)
+        {
+            SharedChange &change = feed[next % SHARED_FEED_SIZE];
+            uint64_t before = change.sequence.load(memory_order_acquire);
+            int code = change.code.load(memory_order_relaxed);
+            int32_t from = change.pid.load(memory_order_relaxed);
+            atomic_thread_fence(memory_order_acquire);
+            uint64_t after = change.sequence.load(memory_order_relaxed);
+            if (before != next || after != next)
+            {
+                if (before > next || after > next)
+                    return false;
+                stalled = true;
+                return true;
+            }
+            if (from != pid)
+                codes.push_back(code);
+            seen = next;
+        }
+        return true;
+    }
+
+    // Copies one product out; record.live is false if it is gone
+    void read(int code, SharedRecord &record)
+    {
+        Guard guard(&header->lock);
+        SharedProduct *slot = probe(code);
+        record.code = code;
+        if (slot->state == SHARED_EMPTY)
+            record.live = false;
+        else
+            read(slot, record);
+    }
+
+    // Visits a copy of every live product, in slot order
+    template <typename Visit>
+    void forEach(Visit visit)
+    {
+        Guard guard(&header->lock);
+        SharedRecord record;
+        for (uint32_t i = 0; i < header->capacity; i++)
+        {
+            if (slots[i].state != SHARED_LIVE)
+                continue;
+            record.code = slots[i].code;
+            read(&slots[i], record);
+            visit(record);
+        }
+    }
+
+    bool owned() const { return !header || header->owner == pid; }
+
+    // Makes this process the owner if the catalog has none, or its owner
+    // died. Returns true only when ownership changes hands.
+    bool claim()
+    {
+        if (!header)
+            return false;
+        Guard guard(&header->lock);
+        if (header->owner == pid || alive(header->owner))
+            return false;
+        header->owner = pid;
+        return true;
+    }
+};
+
+// ======================================
+// Asynchronous Log Writer
+// ======================================
+// Admin operations hand finished log records to a bounded lock-free ring
+// (many producers, one consumer) and return immediately. A background
+// thread drains the ring into per-file buffers and writes each buffer
+// with one write() through a file descriptor it keeps open, flushing
+// every LOG_FLUSH_INTERVAL_MS or sooner once LOG_FLUSH_BYTES are
+// waiting. LOG_SYNC_POLICY decides how often the data is also fsynced.
+//
+// Each log is kept as rotating segments. Records go to the active
+// segment (e.g. ProductLog.txt) until it passes LOG_SEGMENT_BYTES or
+// LOG_SEGMENT_SECONDS, when it is renamed to ProductLog.<n>.txt and a new
+// one is started. Every record begins with a header line giving its time,
+// operation and product code. Each segment also has a sparse index
+// (ProductLog.idx, ProductLog.<n>.idx) with one entry per
+// LOG_INDEX_BLOCK_BYTES of records, holding the block's position, time
+// span, operations and product-code range. An audit query reads the index
+// files and then only the blocks that can match.
+//
+// Processes sharing the directory write the same logs. Each flush locks
+// the active segment, appends at its current end and writes the index
+// entries for what it appended, so entries stay in segment order; the
+// process that finds the segment due rotates it.
+enum LogTarget
 {
-    cout << "Products in the price range $" << minPrice << " - $" << maxPrice << ":\n";
-    cout << "===================================================================\n";
-    cout << "Code\tName\t\tPrice\tDiscount\tStock\tCategory\n";
-    cout << "===================================================================\n";
+    PRODUCT_LOG,
+    PROMOTION_LOG,
+    ANALYTICS_LOG,
+    SALES_REPORT_LOG,
+    LOG_TARGET_COUNT
+};
 
-    inOrderTraversal(productRoot, minPrice, maxPrice);
+const char *const LOG_NAMES[LOG_TARGET_COUNT] = {
+    "ProductLog", "PromotionLog", "AnalyticsLog", "SalesReport"};
 
-    cout << "===================================================================\n";
-}
+enum LogOperation
+{
+    LOG_OP_ADD = 1,
+    LOG_OP_EDIT = 2,
+    LOG_OP_DELETE = 3,
+    LOG_OP_STOCK = 4,     // low stock / restock events
+    LOG_OP_PROMOTION = 5,
+    LOG_OP_REPORT = 6,    // listings, sorts, alerts, analytics and sales reports
+    LOG_OP_COUNT
+};
 
-// ========== IN-ORDER TRAVERSALS ==========
+const char *const LOG_OPERATION_NAMES[LOG_OP_COUNT] = {
+    "", "ADD", "EDIT", "DELETE", "STOCK", "PROMOTION", "REPORT"};
 
-// -------------- HELPER: IN-ORDER (NO FILTER) --------------
-void Shopping::inOrderTraversal(Product *root)
+enum LogSyncPolicy
 {
-    if (!root) return;
-    inOrderTraversal(root->left);
-    cout << root->code << "\t" << root->name << "\t$" << root->price 
-         << "\t" << root->discount << "%\t" << root->stock 
-         << "\t" << root->category << "\n";
-    inOrderTraversal(root->right);
-}
+    LOG_SYNC_NEVER,      // leave it to the OS page cache
+    LOG_SYNC_EACH_FLUSH, // fsync every file written in a flush
+    LOG_SYNC_ON_CLOSE    // fsync when a segment is rotated and at shutdown
+};
 
-// -------------- HELPER: IN-ORDER (FILTER: category) --------------
-void Shopping::inOrderTraversal(Product *root, const string &filter, const string &filterType)
+const size_t LOG_RING_CAPACITY = 4096; // records; must be a power of two
+const int LOG_FLUSH_INTERVAL_MS = 100;
+const size_t LOG_FLUSH_BYTES = 64 * 1024;
+const LogSyncPolicy LOG_SYNC_POLICY = LOG_SYNC_ON_CLOSE;
+const off_t LOG_SEGMENT_BYTES = 16 * 1024 * 1024;
+const time_t LOG_SEGMENT_SECONDS = 24 * 60 * 60;
+const uint32_t LOG_INDEX_BLOCK_BYTES = 16 * 1024;
+const char LOG_INDEX_MAGIC[8] = {'S', 'M', 'L', 'I', 'D', 'X', '\r', '\n'};
+
+struct LogIndexEntry
+{
+    uint64_t offset;     // block start within the segment
+    uint32_t length;     // block size in bytes
+    uint32_t operations; // bit (1 << LogOperation) for every operation present
+    int64_t firstTime;
+    int64_t lastTime;
+    int32_t minCode;     // product codes present; minCode > maxCode if none
+    int32_t maxCode;
+};
+
+// Active segment when sequence < 0, otherwise rotated segment <sequence>
+string logFilePath(LogTarget target, int sequence, const char *extension)
 {
-    if (!root) return;
-    inOrderTraversal(root->left, filter, filterType);
+    string path = LOG_NAMES[target];
+    if (sequence >= 0)
+        path += "." + to_string(sequence);
+    return path + "." + extension;
+}
 
-    if (filterType == "category" && root->category == filter)
+// Rotated segment numbers of a log, ascending
+vector<int> listLogSegments(LogTarget target)
+{
+    vector<int> sequences;
+    string pattern = string(LOG_NAMES[target]) + ".%d.tx%c%c";
+    DIR *dir = opendir(".");
+    if (dir)
     {
-        cout << root->code << "\t" << root->name << "\t$" << root->price 
-             << "\t" << root->discount << "%\t" << root->stock 
-             << "\t" << root->category << "\n";
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != nullptr)
+        {
+            int sequence;
+            char last, tail;
+            if (sscanf(entry->d_name, pattern.c_str(), &sequence, &last, &tail) == 2 && last == 't')
+                sequences.push_back(sequence);
+        }
+        closedir(dir);
     }
+    sort(sequences.begin(), sequences.end());
+    return sequences;
+}
 
-    inOrderTraversal(root->right, filter, filterType);
+// "[2026-01-31 14:03:12 | t=1769868192 | EDIT | code=42]"
+string formatLogHeader(time_t when, LogOperation operation, int code)
+{
+    struct tm local;
+    localtime_r(&when, &local);
+    char stamp[32];
+    strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &local);
+
+    string codeText = code >= 0 ? to_string(code) : "-";
+    char header[128];
+    snprintf(header, sizeof(header), "[%s | t=%lld | %s | code=%s]\n",
+             stamp, (long long)when, LOG_OPERATION_NAMES[operation], codeText.c_str());
+    return header;
 }
 
-// -------------- HELPER: IN-ORDER (FILTER: price range) --------------
-void Shopping::inOrderTraversal(Product *root, float minPrice, float maxPrice)
+bool parseLogHeader(const char *line, time_t &when, int &operation, int &code)
 {
-    if (!root) return;
-    inOrderTraversal(root->left, minPrice, maxPrice);
+    long long seconds;
+    char name[16], codeText[16];
+    if (line[0] != '[' || sscanf(line, "[%*[^|]| t=%lld | %15[A-Z] | code=%15[^]]]", &seconds, name, codeText) != 3)
+        return false;
 
-    if (root->price >= minPrice && root->price <= maxPrice)
+    operation = 0;
+    for (int op = 1; op < LOG_OP_COUNT; op++)
     {
-        cout << root->code << "\t" << root->name << "\t$" << root->price 
-             << "\t" << root->discount << "%\t" << root->stock 
-             << "\t" << root->category << "\n";
+        if (strcmp(name, LOG_OPERATION_NAMES[op]) == 0)
+            operation = op;
     }
-
-    inOrderTraversal(root->right, minPrice, maxPrice);
+    when = time_t(seconds);
+    code = strcmp(codeText, "-") == 0 ? -1 : atoi(codeText);
+    return operation != 0;
 }
 
-// -------------- GENERATE SALES REPORT --------------
-void Shopping::generateSalesReport()
+class LogWriter
 {
-    if (!customerHead)
+private:
+    struct QueuedRecord
     {
-        cout << "No customers found. Sales data unavailable.\n";
-        return;
-    }
+        LogTarget target;
+        time_t time;
+        LogOperation operation;
+        int code;
+        string text;
+    };
+
+    // Bounded MPMC queue after Vyukov: a slot is free for the producer
+    // claiming position p when its sequence equals p, and holds a record
+    // for the consumer when it equals p + 1.
+    struct Slot
+    {
+        atomic<size_t> sequence;
+        QueuedRecord record;
+    };
+
+    // One record waiting in a LogFile's buffer
+    struct PendingRecord
+    {
+        uint32_t length; // header line and text
+        time_t time;
+        LogOperation operation;
+        int code;
+    };
 
-    // Map: productCode -> (totalQtySold, totalRevenue)
-    map<int, pair<int, float>> salesData;
+    // Writer-side state of one log's active segment
+    struct LogFile
+    {
+        int fd;
+        int indexFd;
+        string buffer;                 // records not yet written
+        vector<PendingRecord> records; // what buffer holds
+        off_t blockEntry;              // index position of this process's last entry, -1 if closed
+        off_t blockEnd;                // segment offset just past that entry's block
+    };
+
+    vector<Slot> slots;
+    atomic<size_t> enqueuePosition;
+    size_t dequeuePosition; // consumer thread only
+
+    thread worker;
+    mutex lock;
+    condition_variable wakeup;
+    condition_variable synced;
+    bool wakeRequested;
+    bool stopping;
+    bool running;
+    uint64_t syncRequested;
+    uint64_t syncCompleted;
 
-    // Traverse all customers
-    Customer *cptr = customerHead;
-    while (cptr)
+    LogFile files[LOG_TARGET_COUNT];
+
+    bool tryPush(QueuedRecord &record)
     {
-        Order *order = cptr->orderHistory;
-        while (order)
+        size_t position = enqueuePosition.load(memory_order_relaxed);
+        Slot *slot;
+        while (true)
         {
-            salesData[order->code].first  += order->quantity;
-            salesData[order->code].second += order->totalCost;
-            order = order->next;
+            slot = &slots[position & (LOG_RING_CAPACITY - 1)];
+            size_t sequence = slot->sequence.load(memory_order_acquire);
+            intptr_t difference = intptr_t(sequence) - intptr_t(position);
+            if (difference == 0)
+            {
+                if (enqueuePosition.compare_exchange_weak(position, position + 1, memory_order_relaxed))
+                    break;
+            }
+            else if (difference < 0)
+            {
+                return false; // full
+            }
+            else
+            {
+                position = enqueuePosition.load(memory_order_relaxed);
+            }
         }
-        cptr = cptr->next;
+
+        slot->record.target = record.target;
+        slot->record.time = record.time;
+        slot->record.operation = record.operation;
+        slot->record.code = record.code;
+        slot->record.text.swap(record.text);
+        slot->sequence.store(position + 1, memory_order_release);
+        return true;
     }
 
-    if (salesData.empty())
+    bool tryPop(QueuedRecord &record)
     {
-        cout << "No sales data available.\n";
-        return;
+        Slot &slot = slots[dequeuePosition & (LOG_RING_CAPACITY - 1)];
+        if (slot.sequence.load(memory_order_acquire) != dequeuePosition + 1)
+            return false;
+
+        record.target = slot.record.target;
+        record.time = slot.record.time;
+        record.operation = slot.record.operation;
+        record.code = slot.record.code;
+        record.text.swap(slot.record.text);
+        slot.record.text.clear();
+        slot.sequence.store(dequeuePosition + LOG_RING_CAPACITY, memory_order_release);
+        dequeuePosition++;
+        return true;
     }
 
-    cout << "\nSales Report:\n";
-    cout << "===================================================================\n";
-    cout << "Code\tName\t\tTotal Quantity\tTotal Revenue\n";
-    cout << "===================================================================\n";
-
-    for (auto &entry : salesData)
+    void requestWake()
     {
-        int productCode = entry.first;
-        int totalQuantity = entry.second.first;
-        float totalRevenue = entry.second.second;
+        lock_guard<mutex> guard(lock);
+        wakeRequested = true;
+        wakeup.notify_one();
+    }
 
-        Product *product = findProduct(productRoot, productCode);
-        if (product)
+    // Adds one record to the index entries being built. A block takes
+    // records until it reaches LOG_INDEX_BLOCK_BYTES.
+    static void indexRecord(vector<LogIndexEntry> &blocks, uint64_t offset, uint32_t length,
+                            time_t when, int operation, int code)
+    {
+        if (blocks.empty() || blocks.back().length >= LOG_INDEX_BLOCK_BYTES)
+            blocks.push_back(LogIndexEntry{offset, 0, 0, INT64_MAX, INT64_MIN, INT32_MAX, INT32_MIN});
+
+        LogIndexEntry &block = blocks.back();
+        block.length += length;
+        if (operation == 0)
+            return; // not a record header
+        block.operations |= 1u << operation;
+        block.firstTime = min(block.firstTime, int64_t(when));
+        block.lastTime = max(block.lastTime, int64_t(when));
+        if (code >= 0)
         {
-            cout << product->code << "\t" << product->name << "\t\t" 
-                 << totalQuantity << "\t\t$" << totalRevenue << "\n";
+            block.minCode = min(block.minCode, int32_t(code));
+            block.maxCode = max(block.maxCode, int32_t(code));
         }
-        else
+    }
+
+    bool openSegment(LogTarget target)
+    {
+        LogFile &file = files[target];
+        if (file.fd >= 0)
+            return true;
+
+        // Data before index: see rotate()
+        file.fd = ::open(logFilePath(target, -1, "txt").c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        file.indexFd = ::open(logFilePath(target, -1, "idx").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        file.blockEntry = -1;
+        if (file.fd < 0 || file.indexFd < 0)
         {
-            cout << productCode << "\t" << "Unknown Product" << "\t\t" 
-                 << totalQuantity << "\t\t$" << totalRevenue << "\n";
+            if (file.fd >= 0) ::close(file.fd);
+            if (file.indexFd >= 0) ::close(file.indexFd);
+            file.fd = file.indexFd = -1;
+            return false;
         }
+        return true;
     }
 
-    cout << "===================================================================\n";
-
-    // Save to file
-    ofstream reportFile("SalesReport.txt", ios::app);
-    if (reportFile.is_open())
+    // Drops the lock first: see FileLock
+    void closeSegment(LogFile &file, FileLock &lock)
     {
-        reportFile << "Sales Report:\n";
-        reportFile << "===================================================================\n";
-        reportFile << "Code\tName\t\tTotal Quantity\tTotal Revenue\n";
-        reportFile << "===================================================================\n";
+        lock.release();
+        if (file.fd < 0)
+            return;
+        ::close(file.fd);
+        ::close(file.indexFd);
+        file.fd = file.indexFd = -1;
+    }
 
-        for (auto &entry : salesData)
+    // Opens the active segment and locks it. Processes sharing the
+    // directory write the same logs, and whoever finds a segment due
+    // rotates it, so a lock taken on a segment that has since been renamed
+    // away is dropped and the new one opened instead.
+    bool lockSegment(LogTarget target, FileLock &lock)
+    {
+        LogFile &file = files[target];
+        string path = logFilePath(target, -1, "txt");
+        while (true)
         {
-            int productCode = entry.first;
-            int totalQuantity = entry.second.first;
-            float totalRev = entry.second.second;
+            if (!openSegment(target) || !lock.acquire(file.fd, LOCK_EX))
+                return false;
 
-            Product *product = findProduct(productRoot, productCode);
-            if (product)
-            {
-                reportFile << product->code << "\t" << product->name << "\t\t" 
-                           << totalQuantity << "\t\t$" << totalRev << "\n";
-            }
-            else
+            struct stat opened, current;
+            if (fstat(file.fd, &opened) != 0)
             {
-                reportFile << productCode << "\t" << "Unknown Product" << "\t\t"
-                           << totalQuantity << "\t\t$" << totalRev << "\n";
+                closeSegment(file, lock);
+                return false;
             }
+            if (stat(path.c_str(), &current) == 0 && current.st_dev == opened.st_dev
+                && current.st_ino == opened.st_ino)
+                return true;
+            closeSegment(file, lock);
         }
-
-        reportFile << "===================================================================\n";
-        reportFile.close();
     }
-    else
+
+    // Reads the locked segment's size and checks its index. A writer that
+    // crashed can leave an entry cut short, and records past the last
+    // entry. The torn entry is cut off and entries are added for those
+    // records, so later blocks never hide them from queries. The segment's
+    // age runs from its first indexed record.
+    bool prepareIndex(LogFile &file, off_t &size, off_t &indexSize, time_t &segmentStart)
     {
-        cout << "Error: Unable to write sales report to file.\n";
+        const off_t magicSize = sizeof(LOG_INDEX_MAGIC);
+        const off_t entrySize = sizeof(LogIndexEntry);
+        struct stat data, index;
+        if (fstat(file.fd, &data) != 0 || fstat(file.indexFd, &index) != 0)
+            return false;
+        size = data.st_size;
+        indexSize = index.st_size;
+
+        if (indexSize < magicSize)
+        {
+            if (ftruncate(file.indexFd, 0) != 0
+                || pwrite(file.indexFd, LOG_INDEX_MAGIC, magicSize, 0) != ssize_t(magicSize))
+                return false;
+            indexSize = magicSize;
+        }
+        else if ((indexSize - magicSize) % entrySize != 0)
+        {
+            indexSize -= (indexSize - magicSize) % entrySize;
+            if (ftruncate(file.indexFd, indexSize) != 0)
+                return false;
+        }
+
+        // Entries are written in segment order, so the last one ends the indexed part
+        LogIndexEntry first, last;
+        uint64_t indexedEnd = 0;
+        segmentStart = file.records.empty() ? time(nullptr) : file.records.front().time;
+        if (indexSize > magicSize)
+        {
+            if (pread(file.indexFd, &first, sizeof(first), magicSize) != ssize_t(sizeof(first))
+                || pread(file.indexFd, &last, sizeof(last), indexSize - entrySize) != ssize_t(sizeof(last)))
+                return false;
+            segmentStart = time_t(first.firstTime);
+            indexedEnd = last.offset + last.length;
+        }
+        if (uint64_t(size) <= indexedEnd)
+            return true;
+
+        string tail(size_t(uint64_t(size) - indexedEnd), '\0');
+        if (pread(file.fd, &tail[0], tail.size(), off_t(indexedEnd)) != ssize_t(tail.size()))
+            return false;
+
+        // A record runs from its header line to the next one
+        vector<size_t> starts(1, 0);
+        for (size_t lineStart = 0; lineStart < tail.size(); )
+        {
+            size_t lineEnd = tail.find('\n', lineStart);
+            if (lineEnd == string::npos) lineEnd = tail.size();
+            time_t when;
+            int operation, code;
+            if (lineStart > 0 && tail[lineStart] == '['
+                && parseLogHeader(tail.c_str() + lineStart, when, operation, code))
+                starts.push_back(lineStart);
+            lineStart = lineEnd + 1;
+        }
+
+        vector<LogIndexEntry> blocks;
+        for (size_t i = 0; i < starts.size(); i++)
+        {
+            size_t end = i + 1 < starts.size() ? starts[i + 1] : tail.size();
+            time_t when = 0;
+            int operation = 0, code = -1;
+            if (!parseLogHeader(tail.c_str() + starts[i], when, operation, code))
+                operation = 0;
+            indexRecord(blocks, indexedEnd + starts[i], uint32_t(end - starts[i]), when, operation, code);
+        }
+
+        size_t bytes = blocks.size() * sizeof(LogIndexEntry);
+        if (pwrite(file.indexFd, blocks.data(), bytes, indexSize) != ssize_t(bytes))
+            return false;
+        indexSize += off_t(bytes);
+        if (indexSize == magicSize + off_t(bytes))
+            segmentStart = time_t(blocks.front().firstTime);
+        return true;
     }
-}
 
-// ========== MAIN MENUS ==========
+    // Gives the locked active segment the next free segment number. The
+    // index is renamed first, so a process that opens the new segment's
+    // data file never pairs it with the old index.
+    void rotate(LogTarget target, FileLock &lock)
+    {
+        LogFile &file = files[target];
+        if (LOG_SYNC_POLICY != LOG_SYNC_NEVER)
+        {
+            fsync(file.fd);
+            fsync(file.indexFd);
+        }
 
-// -------------- MAIN MENU --------------
-void Shopping::menu()
-{
-    int choice;
-    do
+        vector<int> sequences = listLogSegments(target);
+        int sequence = sequences.empty() ? 1 : sequences.back() + 1;
+        rename(logFilePath(target, -1, "idx").c_str(), logFilePath(target, sequence, "idx").c_str());
+        rename(logFilePath(target, -1, "txt").c_str(), logFilePath(target, sequence, "txt").c_str());
+        closeSegment(file, lock);
+    }
+
+    // Writes the buffered records of one log with the segment locked, at
+    // wherever it ends now, together with their index entries. This
+    // process's last block goes on growing if nothing was written after
+    // it. Rotates the segment first if it is due.
+    void flush(LogTarget target)
     {
-        cout << "\n\t\tWelcome to the Supermarket System\n";
-        cout << "=====================================\n";
-        cout << "1) Administrator\n";
-        cout << "2) Buyer\n";
-        cout << "3) Exit\n";
-        cout << "=====================================\n";
-        cout << "Enter your choice: ";
-        cin >> choice;
+        LogFile &file = files[target];
+        if (file.buffer.empty())
+            return;
 
-        switch (choice)
+        FileLock lock;
+        off_t size = 0, indexSize = 0;
+        time_t segmentStart = 0;
+        bool ready = lockSegment(target, lock) && prepareIndex(file, size, indexSize, segmentStart);
+        if (ready && size > 0
+            && (size >= LOG_SEGMENT_BYTES || file.records.front().time - segmentStart >= LOG_SEGMENT_SECONDS))
         {
-        case 1:
+            rotate(target, lock);
+            ready = lockSegment(target, lock) && prepareIndex(file, size, indexSize, segmentStart);
+        }
+
+        string path = logFilePath(target, -1, "txt");
+        vector<LogIndexEntry> blocks;
+        off_t entriesAt = indexSize;
+        if (ready && file.blockEntry >= 0 && file.blockEntry + off_t(sizeof(LogIndexEntry)) == indexSize
+            && file.blockEnd == size)
         {
-            // Force admin to login first
-            bool loggedIn = adminLogin();
-            if (loggedIn)
+            blocks.resize(1);
+            ready = pread(file.indexFd, &blocks[0], sizeof(LogIndexEntry), file.blockEntry)
+                    == ssize_t(sizeof(LogIndexEntry));
+            entriesAt = file.blockEntry;
+        }
+        if (!ready)
+        {
+            cout << "Error: Unable to open " << path << " for writing.\n";
+            file.buffer.clear();
+            file.records.clear();
+            closeSegment(file, lock);
+            return;
+        }
+
+        uint64_t offset = uint64_t(size);
+        for (const PendingRecord &record : file.records)
+        {
+            indexRecord(blocks, offset, record.length, record.time, record.operation, record.code);
+            offset += record.length;
+        }
+
+        // Data first, so an index entry never points past the end of the segment
+        size_t bytes = blocks.size() * sizeof(LogIndexEntry);
+        if (!writeAll(file.fd, file.buffer.data(), file.buffer.size())
+            || pwrite(file.indexFd, blocks.data(), bytes, entriesAt) != ssize_t(bytes))
+        {
+            cout << "Error: Unable to write to " << path << ".\n";
+            file.blockEntry = -1;
+        }
+        else
+        {
+            if (LOG_SYNC_POLICY == LOG_SYNC_EACH_FLUSH)
             {
-                administrator();
+                fsync(file.fd);
+                fsync(file.indexFd);
             }
-            break;
+            bool full = blocks.back().length >= LOG_INDEX_BLOCK_BYTES;
+            file.blockEntry = full ? -1 : entriesAt + off_t(bytes - sizeof(LogIndexEntry));
+            file.blockEnd = off_t(offset);
         }
-        case 2:
-            buyer();
-            break;
-        case 3:
-            cout << "Exiting...\n";
-            break;
-        default:
-            cout << "Invalid choice. Please try again.\n";
+        file.buffer.clear();
+        file.records.clear();
+    }
+
+    // Writes what is buffered and closes the active segment
+    void finishSegment(LogTarget target)
+    {
+        LogFile &file = files[target];
+        flush(target);
+        if (file.fd < 0)
+            return;
+        if (LOG_SYNC_POLICY != LOG_SYNC_NEVER)
+        {
+            fsync(file.fd);
+            fsync(file.indexFd);
         }
-    } while (choice != 3);
-}
+        FileLock none;
+        closeSegment(file, none);
+    }
 
-// -------------- ADMINISTRATOR MENU --------------
-void Shopping::administrator()
-{
-    int choice;
-    do
+    void appendRecord(const QueuedRecord &record)
     {
-        cout << "\nAdministrator Menu\n";
-        cout << "=========================\n";
-        cout << "1) Add Product\n";
-        cout << "2) Edit Product\n";
-        cout << "3) Delete Product\n";
-        cout << "4) List Products\n";
-        cout << "5) List Products by Category\n";
-        cout << "6) Search Products by Name\n";
+        LogFile &file = files[record.target];
+        string header = formatLogHeader(record.time, record.operation, record.code);
+        file.buffer += header;
+        file.buffer += record.text;
+        file.records.push_back(PendingRecord{uint32_t(header.size() + record.text.size()), record.time,
+                                             record.operation, record.code});
+        if (file.buffer.size() >= LOG_FLUSH_BYTES)
+            flush(record.target);
+    }
+
+    void drain()
+    {
+        QueuedRecord record;
+        while (tryPop(record))
+            appendRecord(record);
+    }
+
+    void run()
+    {
+        unique_lock<mutex> guard(lock);
+        while (true)
+        {
+            bool finishing = stopping;
+            uint64_t syncing = syncRequested;
+            wakeRequested = false;
+            guard.unlock();
+
+            drain();
+            for (int target = 0; target < LOG_TARGET_COUNT; target++)
+                flush(LogTarget(target));
+
+            guard.lock();
+            syncCompleted = syncing;
+            synced.notify_all();
+            if (finishing)
+                break;
+            wakeup.wait_for(guard, chrono::milliseconds(LOG_FLUSH_INTERVAL_MS),
+                [&] { return stopping || wakeRequested || syncRequested != syncCompleted; });
+        }
+
+        for (int target = 0; target < LOG_TARGET_COUNT; target++)
+            finishSegment(LogTarget(target));
+    }
+
+    // Reads one range of a segment and reports the records in it that match
+    template <typename Visit>
+    int scanRange(int fd, uint64_t offset, uint64_t length, time_t from, time_t to,
+                  int operation, int code, Visit &visit)
+    {
+        string chunk(size_t(length), '\0');
+        if (length == 0 || pread(fd, &chunk[0], chunk.size(), off_t(offset)) != ssize_t(chunk.size()))
+            return 0;
+
+        // A record runs from its header line to the next header line
+        vector<size_t> starts;
+        for (size_t lineStart = 0; lineStart < chunk.size(); )
+        {
+            size_t lineEnd = chunk.find('\n', lineStart);
+            if (lineEnd == string::npos) lineEnd = chunk.size();
+            time_t when;
+            int op, recordCode;
+            if (chunk[lineStart] == '[' && parseLogHeader(chunk.c_str() + lineStart, when, op, recordCode))
+                starts.push_back(lineStart);
+            lineStart = lineEnd + 1;
+        }
+
+        int matches = 0;
+        for (size_t i = 0; i < starts.size(); i++)
+        {
+            time_t when;
+            int op, recordCode;
+            parseLogHeader(chunk.c_str() + starts[i], when, op, recordCode);
+            if (when < from || when > to) continue;
+            if (operation != 0 && op != operation) continue;
+            if (code >= 0 && recordCode != code) continue;
+
+            size_t end = i + 1 < starts.size() ? starts[i + 1] : chunk.size();
+            visit(chunk.substr(starts[i], end - starts[i]));
+            matches++;
+        }
+        return matches;
+    }
+
+public:
+    LogWriter()
+        : slots(LOG_RING_CAPACITY), enqueuePosition(0), dequeuePosition(0),
+          wakeRequested(false), stopping(false), running(false), syncRequested(0), syncCompleted(0)
+    {
+        for (size_t i = 0; i < LOG_RING_CAPACITY; i++)
+            slots[i].sequence.store(i, memory_order_relaxed);
+        for (int target = 0; target < LOG_TARGET_COUNT; target++)
+        {
+            LogFile &file = files[target];
+            file.fd = file.indexFd = -1;
+            file.blockEntry = -1;
+            file.blockEnd = 0;
+        }
+    }
+
+    ~LogWriter() { stop(); }
+
+    void start()
+    {
+        for (int target = 0; target < LOG_TARGET_COUNT; target++)
+        {
+            vector<int> sequences = listLogSegments(LogTarget(target));
+
+            // A log from before segmenting has no index; archive it as is
+            struct stat info;
+            string path = logFilePath(LogTarget(target), -1, "txt");
+            if (stat(path.c_str(), &info) == 0 && info.st_size > 0
+                && stat(logFilePath(LogTarget(target), -1, "idx").c_str(), &info) != 0)
+            {
+                int sequence = sequences.empty() ? 1 : sequences.back() + 1;
+                rename(path.c_str(), logFilePath(LogTarget(target), sequence, "txt").c_str());
+            }
+        }
+
+        stopping = false;
+        running = true;
+        worker = thread(&LogWriter::run, this);
+    }
+
+    // Queues a finished record. Only blocks, yielding to the writer, while
+    // the ring is full.
+    void append(LogTarget target, LogOperation operation, int code, time_t when, string text)
+    {
+        QueuedRecord record{target, when, operation, code, string()};
+        record.text.swap(text);
+
+        if (!running)
+        {
+            // No writer thread (startup/shutdown); write straight through
+            appendRecord(record);
+            flush(target);
+            return;
+        }
+
+        while (!tryPush(record))
+        {
+            requestWake();
+            this_thread::yield();
+        }
+
+        // Wake the writer early every half ring of records instead of
+        // letting a burst wait out the flush interval
+        if ((enqueuePosition.load(memory_order_relaxed) & (LOG_RING_CAPACITY / 2 - 1)) == 0)
+            requestWake();
+    }
+
+    // Blocks until everything queued so far has been written
+    void sync()
+    {
+        if (!running)
+            return;
+        unique_lock<mutex> guard(lock);
+        uint64_t ticket = ++syncRequested;
+        wakeup.notify_one();
+        synced.wait(guard, [&] { return syncCompleted >= ticket; });
+    }
+
+    // Calls visit(recordText) for each record of a log written within
+    // [from, to], optionally limited to one operation (0 = any) and one
+    // product code (-1 = any), oldest segment first. Segments and blocks
+    // whose index entries rule out a match are never read. Returns the
+    // number of matches.
+    template <typename Visit>
+    int query(LogTarget target, time_t from, time_t to, int operation, int code, Visit visit)
+    {
+        sync();
+
+        vector<int> sequences = listLogSegments(target);
+        sequences.push_back(-1); // active segment last
+        int matches = 0;
+        for (int sequence : sequences)
+        {
+            string index;
+            bool indexed = readWholeFile(logFilePath(target, sequence, "idx"), index)
+                && index.size() >= sizeof(LOG_INDEX_MAGIC)
+                && memcmp(index.data(), LOG_INDEX_MAGIC, sizeof(LOG_INDEX_MAGIC)) == 0;
+            if (!indexed && sequence >= 0)
+                continue; // archived pre-segmenting log
+
+            vector<pair<uint64_t, uint64_t>> ranges;
+            uint64_t indexedEnd = 0;
+            size_t entryCount = indexed ? (index.size() - sizeof(LOG_INDEX_MAGIC)) / sizeof(LogIndexEntry) : 0;
+            for (size_t i = 0; i < entryCount; i++)
+            {
+                LogIndexEntry entry;
+                memcpy(&entry, index.data() + sizeof(LOG_INDEX_MAGIC) + i * sizeof(entry), sizeof(entry));
+                indexedEnd = max(indexedEnd, entry.offset + entry.length);
+                if (entry.lastTime < from || entry.firstTime > to) continue;
+                if (operation != 0 && !(entry.operations & (1u << operation))) continue;
+                if (code >= 0 && (code < entry.minCode || code > entry.maxCode)) continue;
+                ranges.push_back(make_pair(entry.offset, uint64_t(entry.length)));
+            }
+
+            int fd = ::open(logFilePath(target, sequence, "txt").c_str(), O_RDONLY);
+            if (fd < 0) continue;
+
+            // Records a crashed writer left without an entry
+            struct stat info;
+            if (sequence < 0 && fstat(fd, &info) == 0 && uint64_t(info.st_size) > indexedEnd)
+                ranges.push_back(make_pair(indexedEnd, uint64_t(info.st_size) - indexedEnd));
+
+            for (const pair<uint64_t, uint64_t> &range : ranges)
+                matches += scanRange(fd, range.first, range.second, from, to, operation, code, visit);
+            ::close(fd);
+        }
+        return matches;
+    }
+
+    // Writes out everything queued, then stops the thread
+    void stop()
+    {
+        if (!running)
+            return;
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+            wakeup.notify_one();
+        }
+        worker.join();
+        running = false;
+    }
+};
+
+// Collects one log record with stream syntax and queues it on close()
+// (or when it goes out of scope), like an ofstream opened in append mode.
+// The record is stamped with the time it was started.
+class LogRecord
+{
+private:
+    LogWriter &writer;
+    LogTarget target;
+    LogOperation operation;
+    int code;
+    time_t started;
+    ostringstream text;
+    bool open;
+
+public:
+    LogRecord(LogWriter &writer, LogTarget target, LogOperation operation, int code = -1)
+        : writer(writer), target(target), operation(operation), code(code), started(time(nullptr)), open(true) {}
+    ~LogRecord() { close(); }
+
+    // Product the record is about, once it is known
+    void setProduct(int productCode) { code = productCode; }
+
+    template <typename T>
+    LogRecord &operator<<(const T &value)
+    {
+        text << value;
+        return *this;
+    }
+
+    void close()
+    {
+        if (!open)
+            return;
+        writer.append(target, operation, code, started, text.str());
+        open = false;
+    }
+};
+
+// ======================================
+// Order Structure for Customers
+// ======================================
+struct Order
+{
+    uint64_t orderId; // shared by every line of one checkout
+    time_t placedAt;
+    int code;
+    string productName;
+    int quantity;
+    float totalCost;
+};
+
+// ======================================
+// Customer Structure
+// ======================================
+// The wishlist is read from the customer's file the first time it is
+// needed, not at login. Orders live in the order ledger.
+struct Customer
+{
+    string username;
+    string password;
+    int loyaltyPoints;
+    Product *wishlist;
+    bool wishlistLoaded;
+};
+
+// ======================================
+// Customer Registry
+// ======================================
+// One resident Customer per username, found through an open-addressing
+// hash table with linear probing. Logging in again returns the same
+// record, so memory grows with distinct customers, not with logins.
+class CustomerRegistry
+{
+private:
+    vector<Customer *> slots; // nullptr marks an empty slot; size is a power of two
+    size_t count;
+
+    size_t slotFor(const string &username) const
+    {
+        size_t mask = slots.size() - 1;
+        size_t slot = hash<string>()(username) & mask;
+        while (slots[slot] && slots[slot]->username != username)
+            slot = (slot + 1) & mask;
+        return slot;
+    }
+
+    // Keeps the load factor under 3/4
+    void grow()
+    {
+        vector<Customer *> old;
+        old.swap(slots);
+        slots.assign(old.size() * 2, nullptr);
+        for (Customer *customer : old)
+        {
+            if (customer)
+                slots[slotFor(customer->username)] = customer;
+        }
+    }
+
+public:
+    CustomerRegistry() : slots(64, nullptr), count(0) {}
+
+    ~CustomerRegistry()
+    {
+        for (Customer *customer : slots)
+        {
+            if (!customer) continue;
+            while (customer->wishlist)
+            {
+                Product *next = customer->wishlist->left;
+                delete customer->wishlist;
+                customer->wishlist = next;
+            }
+            delete customer;
+        }
+    }
+
+    Customer *find(const string &username) const
+    {
+        return slots[slotFor(username)];
+    }
+
+    // Takes ownership; the username must not be registered yet
+    void insert(Customer *customer)
+    {
+        if ((count + 1) * 4 > slots.size() * 3)
+            grow();
+        slots[slotFor(customer->username)] = customer;
+        count++;
+    }
+
+};
+
+// ======================================
+// Customer Database
+// ======================================
+// All accounts live in customers.db instead of one <username>.txt file
+// each. The file is a sequence of 4 KB pages: page 0 holds the header and
+// pages 1..bucketCount are hash buckets. Each bucket page stores fixed
+// 64-byte credential slots inline, and a full bucket chains to overflow
+// pages appended at the end of the file. Finding an account therefore
+// reads one page (more only for an overflowing bucket), and the
+// page-aligned layout can be mapped directly. The table is rebuilt with
+// twice the buckets once it is three-quarters full. Existing per-user
+// files are imported when the database is first created. Processes sharing
+// the catalog share the database: each lookup or addition locks it and
+// reads the header again, so accounts added elsewhere are found.
+const char CUSTOMER_DB_MAGIC[8] = {'S', 'M', 'C', 'U', 'S', 'T', '\r', '\n'};
+const uint32_t CUSTOMER_DB_VERSION = 1;
+const size_t CUSTOMER_PAGE_SIZE = 4096;
+const uint32_t CUSTOMER_MIN_BUCKETS = 64;
+const size_t CUSTOMER_CREDENTIAL_BYTES = 56; // username + password
+const size_t CUSTOMER_SLOTS_PER_PAGE = 63;
+
+struct CustomerDbHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t bucketCount; // power of two
+    uint32_t pageCount;   // header + buckets + overflow pages
+    uint32_t recordCount;
+};
+
+struct CustomerSlot
+{
+    uint32_t hash;
+    uint8_t usernameLength;
+    uint8_t passwordLength;
+    uint16_t reserved;
+    char credentials[CUSTOMER_CREDENTIAL_BYTES]; // username then password
+};
+
+struct CustomerPage
+{
+    uint32_t used;
+    uint32_t overflow; // next page in this bucket's chain, 0 if none
+    CustomerSlot slots[CUSTOMER_SLOTS_PER_PAGE];
+    char padding[CUSTOMER_PAGE_SIZE - 8 - CUSTOMER_SLOTS_PER_PAGE * sizeof(CustomerSlot)];
+};
+
+static_assert(sizeof(CustomerPage) == CUSTOMER_PAGE_SIZE, "customer pages must be exactly one page");
+
+class CustomerStore
+{
+private:
+    string path;
+    int fd;
+    CustomerDbHeader header;
+
+    // FNV-1a: stable across builds, unlike std::hash
+    static uint32_t hashName(const string &username)
+    {
+        uint32_t hash = 2166136261u;
+        for (unsigned char c : username)
+            hash = (hash ^ c) * 16777619u;
+        return hash;
+    }
+
+    bool readPage(uint32_t number, CustomerPage &page) const
+    {
+        return pread(fd, &page, sizeof(page), off_t(number) * CUSTOMER_PAGE_SIZE) == ssize_t(sizeof(page));
+    }
+
+    bool writePage(uint32_t number, const CustomerPage &page)
+    {
+        return pwrite(fd, &page, sizeof(page), off_t(number) * CUSTOMER_PAGE_SIZE) == ssize_t(sizeof(page));
+    }
+
+    bool writeHeader()
+    {
+        char page[CUSTOMER_PAGE_SIZE] = {};
+        memcpy(page, &header, sizeof(header));
+        return pwrite(fd, page, sizeof(page), 0) == ssize_t(sizeof(page));
+    }
+
+    static void fillSlot(CustomerSlot &slot, const string &username, const string &password)
+    {
+        memset(&slot, 0, sizeof(slot));
+        slot.hash = hashName(username);
+        slot.usernameLength = uint8_t(username.size());
+        slot.passwordLength = uint8_t(password.size());
+        memcpy(slot.credentials, username.data(), username.size());
+        memcpy(slot.credentials + username.size(), password.data(), password.size());
+    }
+
+    static bool slotMatches(const CustomerSlot &slot, uint32_t hash, const string &username)
+    {
+        return slot.hash == hash && slot.usernameLength == username.size()
+            && memcmp(slot.credentials, username.data(), username.size()) == 0;
+    }
+
+    // Writes a complete database holding records to a temporary file and
+    // renames it over path, or, creating it, links it there unless another
+    // process got there first. Buckets start at most half full.
+    static bool writeStore(const string &path, const vector<pair<string, string>> &records,
+                           uint32_t bucketCount, bool replace)
+    {
+        while (records.size() * 2 > bucketCount * CUSTOMER_SLOTS_PER_PAGE)
+            bucketCount *= 2;
+
+        vector<CustomerPage> pages(1 + bucketCount);
+        memset(pages.data(), 0, pages.size() * sizeof(CustomerPage));
+        for (const pair<string, string> &record : records)
+        {
+            uint32_t number = 1 + (hashName(record.first) & (bucketCount - 1));
+            while (pages[number].used == CUSTOMER_SLOTS_PER_PAGE)
+            {
+                if (!pages[number].overflow)
+                {
+                    pages.push_back(CustomerPage());
+                    memset(&pages.back(), 0, sizeof(CustomerPage));
+                    pages[number].overflow = uint32_t(pages.size() - 1);
+                }
+                number = pages[number].overflow;
+            }
+            CustomerPage &page = pages[number];
+            fillSlot(page.slots[page.used++], record.first, record.second);
+        }
+
+        CustomerDbHeader fileHeader;
+        memcpy(fileHeader.magic, CUSTOMER_DB_MAGIC, sizeof(CUSTOMER_DB_MAGIC));
+        fileHeader.version = CUSTOMER_DB_VERSION;
+        fileHeader.bucketCount = bucketCount;
+        fileHeader.pageCount = uint32_t(pages.size());
+        fileHeader.recordCount = uint32_t(records.size());
+        memcpy(&pages[0], &fileHeader, sizeof(fileHeader));
+
+        string temporary = path + "." + to_string(getpid()) + ".tmp";
+        int out = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (out < 0) return false;
+        bool ok = writeAll(out, reinterpret_cast<const char *>(pages.data()), pages.size() * sizeof(CustomerPage))
+               && fsync(out) == 0;
+        close(out);
+        if (replace)
+            return ok && rename(temporary.c_str(), path.c_str()) == 0;
+        ok = ok && (link(temporary.c_str(), path.c_str()) == 0 || errno == EEXIST);
+        unlink(temporary.c_str());
+        return ok;
+    }
+
+    // Every account in the database, in page order
+    bool readAll(vector<pair<string, string>> &records) const
+    {
+        CustomerPage page;
+        for (uint32_t number = 1; number < header.pageCount; number++)
+        {
+            if (!readPage(number, page)) return false;
+            for (uint32_t i = 0; i < page.used && i < CUSTOMER_SLOTS_PER_PAGE; i++)
+            {
+                const CustomerSlot &slot = page.slots[i];
+                records.push_back(make_pair(string(slot.credentials, slot.usernameLength),
+                                            string(slot.credentials + slot.usernameLength, slot.passwordLength)));
+            }
+        }
+        return true;
+    }
+
+    // <name>.txt files holding exactly "<name>\n<password>\n" are accounts
+    // from before the database existed
+    static vector<pair<string, string>> findLegacyAccounts()
+    {
+        vector<pair<string, string>> records;
+        DIR *dir = opendir(".");
+        if (!dir) return records;
+
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != nullptr)
+        {
+            string fileName = entry->d_name;
+            if (fileName.size() <= 4 || fileName.compare(fileName.size() - 4, 4, ".txt") != 0)
+                continue;
+
+            string username = fileName.substr(0, fileName.size() - 4);
+            ifstream file(fileName);
+            string storedUsername, storedPassword, extra;
+            if (file >> storedUsername >> storedPassword && !(file >> extra) && storedUsername == username)
+            {
+                if (fits(storedUsername, storedPassword))
+                    records.push_back(make_pair(storedUsername, storedPassword));
+                else
+                    cout << "Warning: Skipping account " << storedUsername << " with over-long credentials.\n";
+            }
+        }
+        closedir(dir);
+        sort(records.begin(), records.end());
+        return records;
+    }
+
+    bool open()
+    {
+        if (fd >= 0)
+            return true;
+
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0)
+        {
+            vector<pair<string, string>> legacy = findLegacyAccounts();
+            if (!writeStore(path, legacy, CUSTOMER_MIN_BUCKETS, false))
+                return false;
+            if (!legacy.empty())
+                cout << "Imported " << legacy.size() << " customer account(s) into " << path << ".\n";
+        }
+
+        fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+        return fd >= 0;
+    }
+
+    void closeFile(FileLock &lock)
+    {
+        lock.release();
+        close(fd);
+        fd = -1;
+    }
+
+    // Locks the database for one lookup or addition and reads its header.
+    // Growing it renames a new file over the old one, so a lock taken on
+    // a file that has since been replaced is dropped and taken again on
+    // the new one.
+    bool lockStore(FileLock &lock, int operation)
+    {
+        while (true)
+        {
+            if (!open() || !lock.acquire(fd, operation))
+                return false;
+
+            struct stat opened, current;
+            if (fstat(fd, &opened) != 0)
+            {
+                closeFile(lock);
+                return false;
+            }
+            if (stat(path.c_str(), &current) == 0 && current.st_dev == opened.st_dev
+                && current.st_ino == opened.st_ino)
+                break;
+            closeFile(lock);
+        }
+
+        if (pread(fd, &header, sizeof(header), 0) != ssize_t(sizeof(header))
+            || memcmp(header.magic, CUSTOMER_DB_MAGIC, sizeof(CUSTOMER_DB_MAGIC)) != 0
+            || header.version != CUSTOMER_DB_VERSION || header.bucketCount == 0)
+        {
+            cout << "Error: " << path << " is not a valid customer database.\n";
+            closeFile(lock);
+            return false;
+        }
+        return true;
+    }
+
+    // Doubles the bucket count by rewriting the whole database, with the
+    // exclusive lock held. The new file is opened on next use.
+    bool grow(FileLock &lock)
+    {
+        vector<pair<string, string>> records;
+        if (!readAll(records)) return false;
+        bool ok = writeStore(path, records, header.bucketCount * 2, true);
+        closeFile(lock);
+        return ok;
+    }
+
+public:
+    explicit CustomerStore(const string &databasePath) : path(databasePath), fd(-1) {}
+    ~CustomerStore()
+    {
+        if (fd >= 0) close(fd);
+    }
+
+    // Credentials must fit in one slot
+    static bool fits(const string &username, const string &password)
+    {
+        return username.size() + password.size() <= CUSTOMER_CREDENTIAL_BYTES;
+    }
+
+    // Looks an account up with a single bucket page read. Returns false
+    // if the database cannot be read; found says whether the account exists.
+    bool find(const string &username, string &password, bool &found)
+    {
+        found = false;
+        FileLock lock;
+        if (!lockStore(lock, LOCK_SH)) return false;
+
+        uint32_t hash = hashName(username);
+        uint32_t number = 1 + (hash & (header.bucketCount - 1));
+        CustomerPage page;
+        while (number != 0)
+        {
+            if (!readPage(number, page)) return false;
+            for (uint32_t i = 0; i < page.used && i < CUSTOMER_SLOTS_PER_PAGE; i++)
+            {
+                if (slotMatches(page.slots[i], hash, username))
+                {
+                    const CustomerSlot &slot = page.slots[i];
+                    password.assign(slot.credentials + slot.usernameLength, slot.passwordLength);
+                    found = true;
+                    return true;
+                }
+            }
+            number = page.overflow;
+        }
+        return true;
+    }
+
+    // Adds a new account unless another process already has. Returns false
+    // if the database cannot be written; added says whether it was new.
+    bool add(const string &username, const string &password, bool &added)
+    {
+        added = false;
+        FileLock lock;
+        if (!lockStore(lock, LOCK_EX)) return false;
+
+        // The end of the bucket's chain, checking the name on the way
+        uint32_t hash = hashName(username);
+        uint32_t number = 1 + (hash & (header.bucketCount - 1));
+        CustomerPage page;
+        while (true)
+        {
+            if (!readPage(number, page)) return false;
+            for (uint32_t i = 0; i < page.used && i < CUSTOMER_SLOTS_PER_PAGE; i++)
+                if (slotMatches(page.slots[i], hash, username))
+                    return true;
+            if (page.used < CUSTOMER_SLOTS_PER_PAGE || !page.overflow)
+                break;
+            number = page.overflow;
+        }
+
+        if (page.used == CUSTOMER_SLOTS_PER_PAGE)
+        {
+            // Write the new overflow page before anything points at it
+            CustomerPage overflow;
+            memset(&overflow, 0, sizeof(overflow));
+            fillSlot(overflow.slots[overflow.used++], username, password);
+            uint32_t overflowNumber = header.pageCount++;
+            header.recordCount++;
+            page.overflow = overflowNumber;
+            if (!writePage(overflowNumber, overflow) || !writeHeader() || !writePage(number, page))
+                return false;
+        }
+        else
+        {
+            fillSlot(page.slots[page.used++], username, password);
+            header.recordCount++;
+            if (!writePage(number, page) || !writeHeader())
+                return false;
+        }
+
+        if (fdatasync(fd) != 0) return false;
+        added = true;
+
+        if (header.recordCount * 4 > header.bucketCount * CUSTOMER_SLOTS_PER_PAGE * 3)
+            return grow(lock);
+        return true;
+    }
+};
+
+// ======================================
+// Order Ledger
+// ======================================
+// Every order line of every customer is appended to one file,
+// orders.ledger. A checkout's lines share an order id. Each record also
+// stores the offset of the same customer's previous record, so a
+// customer's history is a backwards chain starting at their newest
+// record. Reading the newest N orders follows N links and never touches
+// anyone else's records. The chain heads live in memory and are saved to
+// orders.heads on shutdown. Startup only re-reads the records appended
+// after that save, and drops a torn tail using each record's CRC.
+// Processes sharing the catalog share the ledger. A checkout locks it only
+// for its append, after reading the records the others appended since, so
+// order ids and chains stay right; reads take a shared lock.
+const char LEDGER_MAGIC[8] = {'S', 'M', 'L', 'E', 'D', 'G', '\r', '\n'};
+const char LEDGER_HEADS_MAGIC[8] = {'S', 'M', 'H', 'E', 'A', 'D', '\r', '\n'};
+const uint32_t LEDGER_VERSION = 1;
+const size_t ORDER_HISTORY_PAGE_SIZE = 10; // order lines per history page
+const size_t LEDGER_SLICE_RECORDS = 4096;  // fewest records worth a scan thread
+
+struct LedgerRecordHeader
+{
+    uint32_t length;   // whole record, header included
+    uint32_t crc;      // crc32 of everything after this field
+    uint64_t previous; // this customer's previous record, 0 if none
+    uint64_t orderId;
+    int64_t placedAt;
+    int32_t code;
+    int32_t quantity;
+    float totalCost;
+    uint16_t usernameLength;
+    uint16_t nameLength;
+    // username and product name follow
+};
+
+class OrderLedger
+{
+private:
+    struct PendingLine
+    {
+        string username;
+        time_t placedAt;
+        int code;
+        string productName;
+        int quantity;
+        float totalCost;
+    };
+
+    string path;
+    string headsPath;
+    int fd;
+    off_t fileSize;              // bytes of whole records read or written
+    vector<PendingLine> pending; // lines of the next order
+    uint64_t nextId;
+    unordered_map<string, uint64_t> heads; // username -> newest record offset
+
+    static off_t headerSize() { return off_t(sizeof(LEDGER_MAGIC) + sizeof(uint32_t)); }
+
+    template <typename T>
+    static void put(string &out, T value)
+    {
+        out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    // Validates the record at offset within contents and decodes it
+    static bool decode(const string &contents, size_t offset, LedgerRecordHeader &record,
+                       string &username, Order &order)
+    {
+        if (offset + sizeof(record) > contents.size())
+            return false;
+        memcpy(&record, contents.data() + offset, sizeof(record));
+        if (record.length < sizeof(record) || offset + record.length > contents.size()
+            || sizeof(record) + record.usernameLength + record.nameLength != record.length
+            || crc32(contents.data() + offset + 8, record.length - 8) != record.crc)
+            return false;
+
+        const char *strings = contents.data() + offset + sizeof(record);
+        username.assign(strings, record.usernameLength);
+        order.orderId = record.orderId;
+        order.placedAt = time_t(record.placedAt);
+        order.code = record.code;
+        order.productName.assign(strings + record.usernameLength, record.nameLength);
+        order.quantity = record.quantity;
+        order.totalCost = record.totalCost;
+        return true;
+    }
+
+    bool loadHeads(off_t &coveredSize)
+    {
+        string contents;
+        if (!readWholeFile(headsPath, contents)) return false;
+
+        size_t at = sizeof(LEDGER_HEADS_MAGIC);
+        uint64_t ledgerSize, id;
+        uint32_t count;
+        if (contents.size() < at + 8 + 8 + 4 || memcmp(contents.data(), LEDGER_HEADS_MAGIC, at) != 0)
+            return false;
+        memcpy(&ledgerSize, contents.data() + at, 8);
+        memcpy(&id, contents.data() + at + 8, 8);
+        memcpy(&count, contents.data() + at + 16, 4);
+        at += 20;
+
+        unordered_map<string, uint64_t> loaded;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint16_t length;
+            uint64_t offset;
+            if (at + 2 > contents.size()) return false;
+            memcpy(&length, contents.data() + at, 2);
+            if (at + 2 + length + 8 > contents.size()) return false;
+            string username(contents.data() + at + 2, length);
+            memcpy(&offset, contents.data() + at + 2 + length, 8);
+            loaded[username] = offset;
+            at += 2 + length + 8;
+        }
+
+        heads.swap(loaded);
+        nextId = id;
+        coveredSize = off_t(ledgerSize);
+        return true;
+    }
+
+    bool saveHeads()
+    {
+        string contents(LEDGER_HEADS_MAGIC, sizeof(LEDGER_HEADS_MAGIC));
+        put(contents, uint64_t(fileSize));
+        put(contents, nextId);
+        put(contents, uint32_t(heads.size()));
+        for (const pair<const string, uint64_t> &head : heads)
+        {
+            put(contents, uint16_t(head.first.size()));
+            contents += head.first;
+            put(contents, head.second);
+        }
+
+        string temporary = headsPath + ".tmp";
+        int out = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (out < 0) return false;
+        bool ok = writeAll(out, contents.data(), contents.size()) && fsync(out) == 0;
+        close(out);
+        return ok && rename(temporary.c_str(), headsPath.c_str()) == 0;
+    }
+
+    // <name>_orders.txt files from before the ledger; each becomes one
+    // order per file, stamped with the file's modification time
+    void importLegacyOrders()
+    {
+        vector<string> files;
+        DIR *dir = opendir(".");
+        if (!dir) return;
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != nullptr)
+        {
+            string fileName = entry->d_name;
+            const string suffix = "_orders.txt";
+            if (fileName.size() > suffix.size()
+                && fileName.compare(fileName.size() - suffix.size(), suffix.size(), suffix) == 0)
+                files.push_back(fileName);
+        }
+        closedir(dir);
+        sort(files.begin(), files.end());
+
+        size_t imported = 0;
+        for (const string &fileName : files)
+        {
+            string username = fileName.substr(0, fileName.size() - strlen("_orders.txt"));
+            struct stat info;
+            time_t placedAt = stat(fileName.c_str(), &info) == 0 ? info.st_mtime : time(nullptr);
+
+            // Lines are "<code> <name> <quantity> <total>"; names may contain spaces
+            ifstream orderFile(fileName);
+            string line;
+            while (getline(orderFile, line))
+            {
+                size_t nameStart = line.find(' ');
+                size_t totalStart = line.rfind(' ');
+                size_t quantityStart = totalStart == string::npos ? string::npos : line.rfind(' ', totalStart - 1);
+                if (nameStart == string::npos || quantityStart == string::npos || quantityStart <= nameStart)
+                    continue;
+
+                append(username, placedAt, atoi(line.c_str()),
+                       line.substr(nameStart + 1, quantityStart - nameStart - 1),
+                       atoi(line.c_str() + quantityStart + 1), float(atof(line.c_str() + totalStart + 1)));
+            }
+
+            size_t lines = pending.size();
+            uint64_t orderId;
+            if (writePending(orderId))
+                imported += lines;
+        }
+
+        if (imported > 0)
+            cout << "Imported " << imported << " order line(s) into " << path << ".\n";
+    }
+
+    // Reads the records other processes appended since this one last
+    // looked, with the lock held. A torn record left by a process that
+    // died mid-append is cut off under the exclusive lock; under the
+    // shared one it is just not read.
+    bool catchUp(bool exclusive)
+    {
+        struct stat info;
+        if (fstat(fd, &info) != 0) return false;
+        if (info.st_size <= fileSize) return true;
+
+        string contents(size_t(info.st_size - fileSize), '\0');
+        if (pread(fd, &contents[0], contents.size(), fileSize) != ssize_t(contents.size()))
+            return false;
+
+        size_t offset = 0;
+        LedgerRecordHeader record;
+        string username;
+        Order order;
+        while (offset < contents.size() && decode(contents, offset, record, username, order))
+        {
+            heads[username] = uint64_t(fileSize) + offset;
+            nextId = max(nextId, order.orderId + 1);
+            offset += record.length;
+        }
+
+        fileSize += off_t(offset);
+        if (offset != contents.size() && exclusive)
+        {
+            cout << "Warning: Discarding a damaged tail of the order ledger.\n";
+            if (ftruncate(fd, fileSize) != 0) return false;
+        }
+        return true;
+    }
+
+    // Gives the queued lines the next order id and links each into its
+    // customer's chain, then appends them with one write + fdatasync. If
+    // that fails the file is cut back, so the lines are recorded together
+    // or not at all. With the exclusive lock held and caught up.
+    bool writePending(uint64_t &orderId)
+    {
+        orderId = nextId;
+        string records;
+        unordered_map<string, uint64_t> linked; // heads after these lines
+        for (const PendingLine &line : pending)
+        {
+            uint64_t offset = uint64_t(fileSize) + records.size();
+            unordered_map<string, uint64_t>::iterator head = linked.find(line.username);
+            if (head == linked.end())
+            {
+                unordered_map<string, uint64_t>::iterator saved = heads.find(line.username);
+                head = linked.insert(make_pair(line.username, saved == heads.end() ? 0 : saved->second)).first;
+            }
+
+            LedgerRecordHeader record;
+            record.length = uint32_t(sizeof(record) + line.username.size() + line.productName.size());
+            record.crc = 0;
+            record.previous = head->second;
+            record.orderId = orderId;
+            record.placedAt = int64_t(line.placedAt);
+            record.code = line.code;
+            record.quantity = line.quantity;
+            record.totalCost = line.totalCost;
+            record.usernameLength = uint16_t(line.username.size());
+            record.nameLength = uint16_t(line.productName.size());
+
+            size_t start = records.size();
+            records.append(reinterpret_cast<const char *>(&record), sizeof(record));
+            records += line.username;
+            records += line.productName;
+            uint32_t crc = crc32(records.data() + start + 8, record.length - 8);
+            memcpy(&records[start + 4], &crc, sizeof(crc));
+            head->second = offset;
+        }
+        pending.clear();
+        if (records.empty())
+            return true;
+
+        if (!writeAll(fd, records.data(), records.size()) || fdatasync(fd) != 0)
+        {
+            if (ftruncate(fd, fileSize) != 0)
+                cout << "Error: Unable to remove a partly written order from " << path << ".\n";
+            return false;
+        }
+        fileSize += off_t(records.size());
+        nextId++;
+        for (const pair<const string, uint64_t> &head : linked)
+            heads[head.first] = head.second;
+        return true;
+    }
+
+    bool open()
+    {
+        if (fd >= 0)
+            return true;
+
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0) return false;
+
+        // Whoever finds the file empty writes its header
+        FileLock lock(fd, LOCK_EX);
+        struct stat info;
+        if (!lock.held() || fstat(fd, &info) != 0)
+        {
+            lock.release();
+            close(fd);
+            fd = -1;
+            return false;
+        }
+
+        if (info.st_size == 0)
+        {
+            string header(LEDGER_MAGIC, sizeof(LEDGER_MAGIC));
+            put(header, LEDGER_VERSION);
+            if (!writeAll(fd, header.data(), header.size()) || fdatasync(fd) != 0)
+            {
+                lock.release();
+                close(fd);
+                fd = -1;
+                return false;
+            }
+            fileSize = headerSize();
+            nextId = 1;
+            importLegacyOrders();
+            return true;
+        }
+
+        char magic[sizeof(LEDGER_MAGIC)];
+        if (info.st_size < headerSize() || pread(fd, magic, sizeof(magic), 0) != ssize_t(sizeof(magic))
+            || memcmp(magic, LEDGER_MAGIC, sizeof(LEDGER_MAGIC)) != 0)
+        {
+            cout << "Error: " << path << " is not a valid order ledger.\n";
+            lock.release();
+            close(fd);
+            fd = -1;
+            return false;
+        }
+
+        // Heads saved at the last shutdown cover a prefix of the ledger;
+        // only records appended after it are read here
+        off_t covered = 0;
+        if (!loadHeads(covered) || covered < headerSize() || covered > info.st_size)
+        {
+            heads.clear();
+            nextId = 1;
+            covered = headerSize();
+        }
+        fileSize = covered;
+        if (catchUp(true))
+            return true;
+        lock.release();
+        close(fd);
+        fd = -1;
+        return false;
+    }
+
+public:
+    OrderLedger(const string &ledgerPath, const string &headsFilePath)
+        : path(ledgerPath), headsPath(headsFilePath), fd(-1), fileSize(0), nextId(1) {}
+
+    ~OrderLedger()
+    {
+        if (fd < 0) return;
+        {
+            FileLock lock(fd, LOCK_EX);
+            if (lock.held() && catchUp(true))
+                saveHeads();
+        }
+        close(fd);
+    }
+
+    bool ready() { return open(); }
+
+    // Queues one line of the next order
+    void append(const string &username, time_t placedAt, int code, const string &productName,
+                int quantity, float totalCost)
+    {
+        pending.push_back(PendingLine{username, placedAt, code, productName, quantity, totalCost});
+    }
+
+    // Records the queued lines as one order, in O(lines) plus whatever
+    // other processes appended since the last look. orderId is the id
+    // they were given.
+    bool commit(uint64_t &orderId)
+    {
+        bool ok = false;
+        if (open())
+        {
+            FileLock lock(fd, LOCK_EX);
+            ok = lock.held() && catchUp(true) && writePending(orderId);
+        }
+        pending.clear();
+        return ok;
+    }
+
+    // Reads what other processes appended, so size() and the heads are
+    // current
+    bool refresh()
+    {
+        if (!open()) return false;
+        FileLock lock(fd, LOCK_SH);
+        return lock.held() && catchUp(false);
+    }
+
+    // Visits up to limit of a customer's order lines, newest first,
+    // after skipping the newest skip lines. Skipped lines cost one header
+    // read each; names are read only for visited lines. more says whether
+    // older lines remain. Returns false if the ledger cannot be read.
+    template <typename Visit>
+    bool visitHistory(const string &username, size_t skip, size_t limit, Visit visit, bool &more)
+    {
+        more = false;
+        if (!refresh()) return false;
+        unordered_map<string, uint64_t>::const_iterator head = heads.find(username);
+        if (head == heads.end()) return true;
+
+        // Records before fileSize are whole and never change
+        uint64_t offset = head->second;
+        for (size_t index = 0; offset != 0; index++)
+        {
+            if (index >= skip + limit)
+            {
+                more = true;
+                return true;
+            }
+
+            LedgerRecordHeader record;
+            if (pread(fd, &record, sizeof(record), off_t(offset)) != ssize_t(sizeof(record)))
+                return false;
+
+            if (index >= skip)
+            {
+                string productName(record.nameLength, '\0');
+                if (record.nameLength > 0
+                    && pread(fd, &productName[0], productName.size(),
+                             off_t(offset + sizeof(record) + record.usernameLength)) != ssize_t(productName.size()))
+                    return false;
+                visit(Order{record.orderId, time_t(record.placedAt), record.code, productName,
+                            record.quantity, record.totalCost});
+            }
+            offset = record.previous;
+        }
+        return true;
+    }
+
+    // Bytes of committed records, header included, as of the last
+    // commit or refresh; a record boundary
+    off_t size()
+    {
+        return open() ? fileSize : 0;
+    }
+
+    // Visits every order line from the record boundary `from` (0 for the
+    // start) to the end of the ledger on up to `workers` threads. One
+    // pass over the record lengths frames the range, then each thread
+    // checks and decodes an equal slice of the records and calls
+    // visit(worker, username, order) for its own slice only, so state
+    // kept per worker needs no locking. Returns the number of workers used.
+    template <typename Visit>
+    size_t forEachOrderParallel(off_t from, size_t workers, Visit visit)
+    {
+        if (!open()) return 0;
+        from = max(from, headerSize());
+        if (from >= fileSize) return 0;
+
+        string contents(size_t(fileSize - from), '\0');
+        if (pread(fd, &contents[0], contents.size(), from) != ssize_t(contents.size()))
+            return 0;
+
+        vector<size_t> offsets;
+        size_t offset = 0;
+        while (offset + sizeof(LedgerRecordHeader) <= contents.size())
+        {
+            uint32_t length;
+            memcpy(&length, contents.data() + offset, sizeof(length));
+            if (length < sizeof(LedgerRecordHeader) || offset + length > contents.size())
+                break;
+            offsets.push_back(offset);
+            offset += length;
+        }
+
+        size_t records = offsets.size();
+        workers = max<size_t>(1, min(workers, records / LEDGER_SLICE_RECORDS));
+
+        vector<thread> threads;
+        for (size_t worker = 0; worker < workers; worker++)
+        {
+            size_t first = records * worker / workers;
+            size_t last = records * (worker + 1) / workers;
+            auto scan = [&contents, &offsets, &visit, worker, first, last]()
+            {
+                LedgerRecordHeader record;
+                string username;
+                Order order;
+                for (size_t i = first; i < last; i++)
+                {
+                    if (decode(contents, offsets[i], record, username, order))
+                        visit(worker, username, order);
+                }
+            };
+
+            // The calling thread takes the last slice itself
+            if (worker + 1 == workers)
+                scan();
+            else
+                threads.push_back(thread(scan));
+        }
+        for (thread &worker : threads)
+            worker.join();
+        return workers;
+    }
+
+    // Visits every order line in the ledger, oldest first
+    template <typename Visit>
+    void forEachOrder(Visit visit)
+    {
+        if (!refresh()) return;
+        string contents(size_t(fileSize), '\0');
+        if (pread(fd, &contents[0], contents.size(), 0) != ssize_t(contents.size())) return;
+
+        size_t offset = size_t(headerSize());
+        LedgerRecordHeader record;
+        string username;
+        Order order;
+        while (offset < contents.size() && decode(contents, offset, record, username, order))
+        {
+            visit(username, order);
+            offset += record.length;
+        }
+    }
+};
+
+// ======================================
+// Sales Rollups
+// ======================================
+// Quantity sold and revenue per product, pre-aggregated by hour, day and
+// month. Each sale goes into the bucket for its hour. Once an hour is
+// over it is folded into its day, and once a day is over it is also
+// added to its month. Days are kept after that, so a date range is
+// answered from whole months where it covers them and from days at the
+// edges: a handful of buckets instead of every order line. The buckets
+// cover the ledger up to an offset, and new records, this process's or
+// another's, are folded in from there after each checkout. The three
+// levels are saved to sales.hours, sales.days and sales.months on
+// shutdown, together with the ledger size they cover. Startup folds in
+// only the ledger records past that size. Without usable files, the whole
+// ledger is rolled up again in parallel: each worker fills its own
+// buckets from its slice and the buckets are merged at the end.
+const char ROLLUP_MAGIC[8] = {'S', 'M', 'R', 'O', 'L', 'L', '\r', '\n'};
+const char *const ROLLUP_FILES[] = {"sales.hours", "sales.days", "sales.months"};
+
+enum RollupLevel
+{
+    ROLLUP_HOUR,
+    ROLLUP_DAY,
+    ROLLUP_MONTH,
+    ROLLUP_LEVELS
+};
+
+struct ProductSales
+{
+    int quantity;
+    double revenue;
+};
+
+struct RollupFileHeader
+{
+    char magic[8];
+    uint32_t level;
+    int32_t zoneCheck;        // see zoneCheck() below
+    uint64_t ledgerSize;      // ledger bytes these buckets cover
+    int64_t hoursFoldedUntil; // hours before this are in the days
+    int64_t daysFoldedUntil;  // days before this are in the months
+    uint64_t count;
+};
+
+struct RollupFileEntry
+{
+    int64_t start;
+    int32_t code;
+    int32_t quantity;
+    double revenue;
+};
+
+// Bucket start -> product code -> totals
+typedef map<time_t, map<int, ProductSales>> RollupBuckets;
+
+class SalesRollups
+{
+private:
+    OrderLedger &ledger;
+    RollupBuckets buckets[ROLLUP_LEVELS];
+    time_t hoursFoldedUntil;
+    time_t daysFoldedUntil;
+    off_t covered; // ledger bytes folded into the buckets
+    bool loaded;
+
+    // Local-time bucket containing t, as [start, end)
+    static void periodOf(time_t t, RollupLevel level, time_t &start, time_t &end)
+    {
+        struct tm local;
+        localtime_r(&t, &local);
+        local.tm_sec = 0;
+        local.tm_min = 0;
+        if (level != ROLLUP_HOUR) local.tm_hour = 0;
+        if (level == ROLLUP_MONTH) local.tm_mday = 1;
+        local.tm_isdst = -1;
+        start = mktime(&local);
+
+        if (level == ROLLUP_HOUR) local.tm_hour++;
+        else if (level == ROLLUP_DAY) local.tm_mday++;
+        else local.tm_mon++;
+        local.tm_isdst = -1;
+        end = mktime(&local);
+    }
+
+    static time_t startOf(time_t t, RollupLevel level)
+    {
+        time_t start, end;
+        periodOf(t, level, start, end);
+        return start;
+    }
+
+    // Buckets start at local midnights; this changes with the time zone,
+    // and saved buckets are not reused across one
+    static int32_t zoneCheck()
+    {
+        const time_t reference = 1000000000;
+        return int32_t(reference - startOf(reference, ROLLUP_DAY));
+    }
+
+    static void addTo(RollupBuckets &level, time_t start, int code, int quantity, double revenue)
+    {
+        ProductSales &sales = level[start][code];
+        sales.quantity += quantity;
+        sales.revenue += revenue;
+    }
+
+    static void mergeInto(RollupBuckets &into, const RollupBuckets &from)
+    {
+        for (const pair<const time_t, map<int, ProductSales>> &bucket : from)
+            for (const pair<const int, ProductSales> &entry : bucket.second)
+                addTo(into, bucket.first, entry.first, entry.second.quantity, entry.second.revenue);
+    }
+
+    // Buckets of one sale, routed past the levels already folded; the
+    // periods of the last call are reused, since sales arrive in time order
+    struct Router
+    {
+        time_t start[ROLLUP_LEVELS];
+        time_t end[ROLLUP_LEVELS];
+
+        Router()
+        {
+            for (int level = 0; level < ROLLUP_LEVELS; level++)
+                start[level] = end[level] = 0;
+        }
+
+        void add(RollupBuckets *into, time_t hoursFolded, time_t daysFolded, time_t placedAt,
+                 int code, int quantity, double revenue)
+        {
+            for (int level = 0; level < ROLLUP_LEVELS; level++)
+            {
+                if (placedAt < start[level] || placedAt >= end[level])
+                    periodOf(placedAt, RollupLevel(level), start[level], end[level]);
+            }
+
+            if (start[ROLLUP_HOUR] >= hoursFolded)
+            {
+                addTo(into[ROLLUP_HOUR], start[ROLLUP_HOUR], code, quantity, revenue);
+                return;
+            }
+            addTo(into[ROLLUP_DAY], start[ROLLUP_DAY], code, quantity, revenue);
+            if (start[ROLLUP_DAY] < daysFolded)
+                addTo(into[ROLLUP_MONTH], start[ROLLUP_MONTH], code, quantity, revenue);
+        }
+    };
+
+    // Folds hours that are over into their days, and days that are over
+    // into their months
+    void compact(time_t now)
+    {
+        time_t currentHour = startOf(now, ROLLUP_HOUR);
+        if (currentHour <= hoursFoldedUntil)
+            return;
+
+        RollupBuckets &hours = buckets[ROLLUP_HOUR];
+        while (!hours.empty() && hours.begin()->first < currentHour)
+        {
+            time_t day = startOf(hours.begin()->first, ROLLUP_DAY);
+            for (const pair<const int, ProductSales> &entry : hours.begin()->second)
+                addTo(buckets[ROLLUP_DAY], day, entry.first, entry.second.quantity, entry.second.revenue);
+            hours.erase(hours.begin());
+        }
+        hoursFoldedUntil = currentHour;
+
+        time_t currentDay = startOf(now, ROLLUP_DAY);
+        RollupBuckets &days = buckets[ROLLUP_DAY];
+        for (RollupBuckets::const_iterator day = days.lower_bound(daysFoldedUntil);
+             day != days.end() && day->first < currentDay; ++day)
+        {
+            time_t month = startOf(day->first, ROLLUP_MONTH);
+            for (const pair<const int, ProductSales> &entry : day->second)
+                addTo(buckets[ROLLUP_MONTH], month, entry.first, entry.second.quantity, entry.second.revenue);
+        }
+        daysFoldedUntil = max(daysFoldedUntil, currentDay);
+    }
+
+    bool loadFiles(off_t &savedSize)
+    {
+        RollupBuckets read[ROLLUP_LEVELS];
+        RollupFileHeader first = RollupFileHeader();
+        for (int level = 0; level < ROLLUP_LEVELS; level++)
+        {
+            string contents;
+            RollupFileHeader header;
+            if (!readWholeFile(ROLLUP_FILES[level], contents) || contents.size() < sizeof(header))
+                return false;
+            memcpy(&header, contents.data(), sizeof(header));
+            if (memcmp(header.magic, ROLLUP_MAGIC, sizeof(ROLLUP_MAGIC)) != 0 || header.level != uint32_t(level)
+                || header.zoneCheck != zoneCheck()
+                || contents.size() != sizeof(header) + header.count * sizeof(RollupFileEntry))
+                return false;
+
+            // All three levels must come from the same save
+            if (level == 0)
+                first = header;
+            else if (header.ledgerSize != first.ledgerSize || header.hoursFoldedUntil != first.hoursFoldedUntil
+                     || header.daysFoldedUntil != first.daysFoldedUntil)
+                return false;
+
+            for (uint64_t i = 0; i < header.count; i++)
+            {
+                RollupFileEntry entry;
+                memcpy(&entry, contents.data() + sizeof(header) + i * sizeof(entry), sizeof(entry));
+                addTo(read[level], time_t(entry.start), entry.code, entry.quantity, entry.revenue);
+            }
+        }
+
+        for (int level = 0; level < ROLLUP_LEVELS; level++)
+            buckets[level].swap(read[level]);
+        savedSize = off_t(first.ledgerSize);
+        hoursFoldedUntil = time_t(first.hoursFoldedUntil);
+        daysFoldedUntil = time_t(first.daysFoldedUntil);
+        return true;
+    }
+
+    bool saveFiles()
+    {
+        for (int level = 0; level < ROLLUP_LEVELS; level++)
+        {
+            RollupFileHeader header;
+            memcpy(header.magic, ROLLUP_MAGIC, sizeof(ROLLUP_MAGIC));
+            header.level = uint32_t(level);
+            header.zoneCheck = zoneCheck();
+            header.ledgerSize = uint64_t(covered);
+            header.hoursFoldedUntil = int64_t(hoursFoldedUntil);
+            header.daysFoldedUntil = int64_t(daysFoldedUntil);
+            header.count = 0;
+
+            string contents(reinterpret_cast<const char *>(&header), sizeof(header));
+            for (const pair<const time_t, map<int, ProductSales>> &bucket : buckets[level])
+            {
+                for (const pair<const int, ProductSales> &sales : bucket.second)
+                {
+                    RollupFileEntry entry = {int64_t(bucket.first), sales.first,
+                                             sales.second.quantity, sales.second.revenue};
+                    contents.append(reinterpret_cast<const char *>(&entry), sizeof(entry));
+                    header.count++;
+                }
+            }
+            memcpy(&contents[0], &header, sizeof(header));
+
+            string temporary = string(ROLLUP_FILES[level]) + ".tmp";
+            int out = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (out < 0) return false;
+            bool ok = writeAll(out, contents.data(), contents.size()) && fsync(out) == 0;
+            close(out);
+            if (!ok || rename(temporary.c_str(), ROLLUP_FILES[level]) != 0)
+                return false;
+        }
+        return true;
+    }
+
+    // Rolls up ledger records from `from` on, one set of buckets per worker
+    void rollUpLedger(off_t from)
+    {
+        size_t workers = max(1u, thread::hardware_concurrency());
+        vector<Router> routers(workers);
+        vector<vector<RollupBuckets>> partials(workers, vector<RollupBuckets>(ROLLUP_LEVELS));
+        time_t hoursFolded = hoursFoldedUntil;
+        time_t daysFolded = daysFoldedUntil;
+
+        workers = ledger.forEachOrderParallel(from, workers,
+            [&routers, &partials, hoursFolded, daysFolded](size_t worker, const string &, const Order &order)
+            {
+                routers[worker].add(&partials[worker][0], hoursFolded, daysFolded, order.placedAt,
+                                    order.code, order.quantity, order.totalCost);
+            });
+
+        for (size_t worker = 0; worker < workers; worker++)
+            for (int level = 0; level < ROLLUP_LEVELS; level++)
+                mergeInto(buckets[level], partials[worker][level]);
+        covered = max(from, ledger.size());
+    }
+
+public:
+    explicit SalesRollups(OrderLedger &orderLedger)
+        : ledger(orderLedger), hoursFoldedUntil(0), daysFoldedUntil(0), covered(0), loaded(false) {}
+
+    ~SalesRollups()
+    {
+        if (loaded && !saveFiles())
+            cout << "Error: Unable to save sales rollups.\n";
+    }
+
+    // Loads the saved rollups and folds in the ledger records after them
+    bool load()
+    {
+        if (loaded)
+            return true;
+        if (!ledger.refresh())
+            return false;
+
+        if (!loadFiles(covered) || covered > ledger.size())
+        {
+            for (int level = 0; level < ROLLUP_LEVELS; level++)
+                buckets[level].clear();
+            time_t now = time(nullptr);
+            hoursFoldedUntil = startOf(now, ROLLUP_HOUR);
+            daysFoldedUntil = startOf(now, ROLLUP_DAY);
+            covered = 0;
+        }
+
+        rollUpLedger(covered);
+        compact(time(nullptr));
+        loaded = true;
+        return true;
+    }
+
+    // Folds in the order lines the ledger has read or written since the
+    // last call; after a checkout, its own lines and any placed by other
+    // processes before it
+    void update()
+    {
+        if (!loaded)
+            return;
+        compact(time(nullptr));
+        rollUpLedger(covered);
+    }
+
+    // Totals per product for sales placed in [from, to). Whole months
+    // that have been folded come from their month bucket; the rest from
+    // day buckets and any hours not yet folded.
+    map<int, ProductSales> report(time_t from, time_t to)
+    {
+        map<int, ProductSales> totals;
+        if (!load())
+            return totals;
+        // Sales other processes placed since
+        ledger.refresh();
+        update();
+
+        auto add = [&totals](const map<int, ProductSales> &bucket)
+        {
+            for (const pair<const int, ProductSales> &entry : bucket)
+            {
+                ProductSales &sales = totals[entry.first];
+                sales.quantity += entry.second.quantity;
+                sales.revenue += entry.second.revenue;
+            }
+        };
+
+        // Days are never dropped, so nothing precedes the first day or hour
+        time_t earliest = to;
+        for (int level = ROLLUP_HOUR; level <= ROLLUP_DAY; level++)
+            if (!buckets[level].empty())
+                earliest = min(earliest, buckets[level].begin()->first);
+        if (from < earliest)
+            from = max(from, startOf(earliest, ROLLUP_MONTH));
+
+        time_t monthStart = startOf(from, ROLLUP_MONTH);
+        while (monthStart < to)
+        {
+            time_t start, monthEnd;
+            periodOf(monthStart, ROLLUP_MONTH, start, monthEnd);
+
+            time_t windowStart = max(from, monthStart);
+            time_t windowEnd = min(to, monthEnd);
+            if (windowStart == monthStart && windowEnd == monthEnd && monthEnd <= daysFoldedUntil)
+            {
+                RollupBuckets::const_iterator month = buckets[ROLLUP_MONTH].find(monthStart);
+                if (month != buckets[ROLLUP_MONTH].end())
+                    add(month->second);
+            }
+            else
+            {
+                for (int level = ROLLUP_HOUR; level <= ROLLUP_DAY; level++)
+                {
+                    for (RollupBuckets::const_iterator bucket = buckets[level].lower_bound(windowStart);
+                         bucket != buckets[level].end() && bucket->first < windowEnd; ++bucket)
+                        add(bucket->second);
+                }
+            }
+            monthStart = monthEnd;
+        }
+        return totals;
+    }
+};
+
+// ======================================
+// Reservation Timing Wheel
+// ======================================
+// Units in a cart are held for RESERVATION_TTL_SECONDS after their line
+// was last changed, then go back to stock. Holds wait in a hierarchical
+// timing wheel: four levels of 64 slots, where a level-0 slot is one
+// second and each slot higher up spans a whole turn of the level below,
+// so the wheel reaches about 194 days ahead. A hold goes into the lowest
+// level that reaches its expiry time. Each second fires the next level-0
+// slot, and whenever a level's position wraps round, the next slot of the
+// level above is spread over the levels below. Adding, renewing,
+// cancelling and expiring a hold are all O(1), and holds that are not
+// due are never looked at. Times come from the monotonic clock, so
+// setting the wall clock does not release anything early.
+const int RESERVATION_TTL_SECONDS = 15 * 60;
+
+struct Session;
+
+struct ReservationHandle
+{
+    int node;        // -1 when nothing is held
+    uint32_t ticket; // tells a live hold from a node reused after it fired
+};
+
+// A hold that has fired; the cart line it belonged to is still there
+// only if the line's ticket matches
+struct Reservation
+{
+    Session *session;
+    int code;
+    uint32_t ticket;
+};
+
+class ReservationWheel
+{
+private:
+    static const int LEVEL_BITS = 6;
+    static const int SLOTS = 1 << LEVEL_BITS;
+    static const int LEVELS = 4;
+    static const int64_t SPAN = int64_t(1) << (LEVEL_BITS * LEVELS);
+
+    struct Node
+    {
+        Session *session;
+        int code;
+        uint32_t ticket; // 0 while the node is free
+        int64_t expiresAt;
+        int bucket;      // level * SLOTS + slot
+        int prev;
+        int next;        // also links the free list
+    };
+
+    mutex lock;
+    vector<Node> nodes;
+    int freeNodes;
+    int heads[LEVELS * SLOTS]; // first node in each slot, -1 if empty
+    int64_t current;           // the next second to fire
+    uint32_t nextTicket;
+    size_t held;
+
+    void link(int index)
+    {
+        Node &node = nodes[index];
+        if (node.expiresAt < current)
+            node.expiresAt = current; // overdue: fires on the next tick
+        if (node.expiresAt - current >= SPAN)
+            node.expiresAt = current + SPAN - 1;
+
+        int64_t until = node.expiresAt - current;
+        int level = 0;
+        while (until >= (int64_t(1) << (LEVEL_BITS * (level + 1))))
+            level++;
+
+        node.bucket = level * SLOTS + int((node.expiresAt >> (LEVEL_BITS * level)) & (SLOTS - 1));
+        node.prev = -1;
+        node.next = heads[node.bucket];
+        if (node.next >= 0)
+            nodes[node.next].prev = index;
+        heads[node.bucket] = index;
+    }
+
+    void unlink(int index)
+    {
+        Node &node = nodes[index];
+        if (node.prev >= 0)
+            nodes[node.prev].next = node.next;
+        else
+            heads[node.bucket] = node.next;
+        if (node.next >= 0)
+            nodes[node.next].prev = node.prev;
+    }
+
+    int allocate()
+    {
+        if (freeNodes < 0)
+        {
+            nodes.push_back(Node());
+            return int(nodes.size() - 1);
+        }
+        int index = freeNodes;
+        freeNodes = nodes[index].next;
+        return index;
+    }
+
+    void release(int index)
+    {
+        nodes[index].ticket = 0;
+        nodes[index].next = freeNodes;
+        freeNodes = index;
+        held--;
+    }
+
+    bool live(ReservationHandle handle) const
+    {
+        return handle.node >= 0 && size_t(handle.node) < nodes.size()
+            && handle.ticket != 0 && nodes[handle.node].ticket == handle.ticket;
+    }
+
+    // Fires the slot for second `current`, after spreading out the slots
+    // of every level whose position wraps round at that second
+    void tick(vector<Reservation> &expired)
+    {
+        for (int level = 1; level < LEVELS; level++)
+        {
+            if (current & ((int64_t(1) << (LEVEL_BITS * level)) - 1))
+                break;
+            int bucket = level * SLOTS + int((current >> (LEVEL_BITS * level)) & (SLOTS - 1));
+            int index = heads[bucket];
+            heads[bucket] = -1;
+            while (index >= 0)
+            {
+                int next = nodes[index].next;
+                link(index);
+                index = next;
+            }
+        }
+
+        int bucket = int(current & (SLOTS - 1));
+        int index = heads[bucket];
+        heads[bucket] = -1;
+        while (index >= 0)
+        {
+            const Node &node = nodes[index];
+            int next = node.next;
+            expired.push_back(Reservation{node.session, node.code, node.ticket});
+            release(index);
+            index = next;
+        }
+        current++;
+    }
+
+public:
+    ReservationWheel() : freeNodes(-1), current(clock()), nextTicket(1), held(0)
+    {
+        fill(heads, heads + LEVELS * SLOTS, -1);
+    }
+
+    // Seconds on the monotonic clock
+    static int64_t clock()
+    {
+        return chrono::duration_cast<chrono::seconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    size_t size()
+    {
+        lock_guard<mutex> guard(lock);
+        return held;
+    }
+
+    // Moves a live hold to its new expiry time, or starts a new hold if
+    // the old one has already fired (or there was none)
+    ReservationHandle renew(ReservationHandle handle, Session *session, int code, int64_t expiresAt)
+    {
+        lock_guard<mutex> guard(lock);
+        if (live(handle))
+        {
+            unlink(handle.node);
+        }
+        else
+        {
+            handle.node = allocate();
+            handle.ticket = nextTicket++;
+            if (nextTicket == 0)
+                nextTicket = 1;
+            held++;
+        }
+
+        Node &node = nodes[handle.node];
+        node.session = session;
+        node.code = code;
+        node.ticket = handle.ticket;
+        node.expiresAt = expiresAt;
+        link(handle.node);
+        return handle;
+    }
+
+    ReservationHandle hold(Session *session, int code, int64_t expiresAt)
+    {
+        return renew(ReservationHandle{-1, 0}, session, code, expiresAt);
+    }
+
+    // A hold that has already fired is left alone
+    void cancel(ReservationHandle handle)
+    {
+        lock_guard<mutex> guard(lock);
+        if (!live(handle))
+            return;
+        unlink(handle.node);
+        release(handle.node);
+    }
+
+    // Seconds until the hold fires, or 0 if it is not live
+    int64_t remaining(ReservationHandle handle, int64_t now)
+    {
+        lock_guard<mutex> guard(lock);
+        if (!live(handle))
+            return 0;
+        return max<int64_t>(nodes[handle.node].expiresAt - now, 0);
+    }
+
+    // Fires every second up to and including `now`
+    void advance(int64_t now, vector<Reservation> &expired)
+    {
+        lock_guard<mutex> guard(lock);
+        while (current <= now)
+            tick(expired);
+    }
+};
+
+// ======================================
+// Cart
+// ======================================
+// One line per product code, holding the quantity and the price and
+// discount in effect when the product was first added. Lines are stored
+// densely, and an open-addressing table of line indexes (linear probing)
+// finds them by code, so adding, changing or removing a line is O(1)
+// however large the cart grows. The subtotal and the amount taken off by
+// discounts are running sums. The units in a cart are already taken out
+// of stock, so a line's product stays valid until it is removed. Each
+// line's units are held under a reservation that returns them to stock
+// if the line is left untouched too long.
+struct CartLine
+{
+    int code;
+    int quantity;
+    float price;      // list price when added
+    float discount;   // percent, when added
+    Product *product; // for the name; removed from the cart if deleted
+    ReservationHandle hold;
+};
+
+class Cart
+{
+private:
+    vector<CartLine> lines;
+    vector<int> slots; // index into lines, -1 marks an empty slot; size is a power of two
+    double subtotal;
+    double discountTotal;
+
+    static size_t hashCode(int code)
+    {
+        uint32_t h = uint32_t(code);
+        h ^= h >> 16;
+        h *= 0x45d9f3bu;
+        h ^= h >> 16;
+        return h;
+    }
+
+    size_t slotFor(int code) const
+    {
+        size_t mask = slots.size() - 1;
+        size_t slot = hashCode(code) & mask;
+        while (slots[slot] >= 0 && lines[slots[slot]].code != code)
+            slot = (slot + 1) & mask;
+        return slot;
+    }
+
+    // Keeps the load factor under 3/4
+    void grow()
+    {
+        slots.assign(slots.size() * 2, -1);
+        for (size_t i = 0; i < lines.size(); i++)
+            slots[slotFor(lines[i].code)] = int(i);
+    }
+
+    void account(const CartLine &line, int sign)
+    {
+        double amount = double(line.price) * line.quantity;
+        subtotal += sign * amount;
+        discountTotal += sign * amount * line.discount / 100.0;
+    }
+
+    // Backward-shift deletion, so no tombstones build up
+    void clearSlot(size_t hole)
+    {
+        size_t mask = slots.size() - 1;
+        for (size_t next = (hole + 1) & mask; slots[next] >= 0; next = (next + 1) & mask)
+        {
+            size_t home = hashCode(lines[slots[next]].code) & mask;
+            if (((next - home) & mask) >= ((next - hole) & mask))
+            {
+                slots[hole] = slots[next];
+                hole = next;
+            }
+        }
+        slots[hole] = -1;
+    }
+
+public:
+    Cart() : slots(16, -1), subtotal(0), discountTotal(0) {}
+
+    bool empty() const { return lines.empty(); }
+    vector<CartLine>::const_iterator begin() const { return lines.begin(); }
+    vector<CartLine>::const_iterator end() const { return lines.end(); }
+
+    double listTotal() const { return subtotal; }
+    double discounts() const { return discountTotal; }
+
+    const CartLine *find(int code) const
+    {
+        int index = slots[slotFor(code)];
+        return index < 0 ? nullptr : &lines[index];
+    }
+
+    // Adds units to the product's line, creating it at the current price
+    const CartLine &add(Product *product, int quantity)
+    {
+        size_t slot = slotFor(product->code);
+        if (slots[slot] < 0)
+        {
+            if ((lines.size() + 1) * 4 > slots.size() * 3)
+            {
+                grow();
+                slot = slotFor(product->code);
+            }
+            slots[slot] = int(lines.size());
+            lines.push_back(CartLine{product->code, 0, product->price, product->discount, product,
+                                     ReservationHandle{-1, 0}});
+        }
+
+        CartLine &line = lines[slots[slot]];
+        account(line, -1);
+        line.quantity += quantity;
+        account(line, 1);
+        return line;
+    }
+
+    void setHold(int code, ReservationHandle hold)
+    {
+        int index = slots[slotFor(code)];
+        if (index >= 0)
+            lines[index].hold = hold;
+    }
+
+    // quantity must be positive; use remove() for zero
+    void setQuantity(int code, int quantity)
+    {
+        int index = slots[slotFor(code)];
+        if (index < 0) return;
+        account(lines[index], -1);
+        lines[index].quantity = quantity;
+        account(lines[index], 1);
+    }
+
+    void remove(int code)
+    {
+        size_t slot = slotFor(code);
+        int index = slots[slot];
+        if (index < 0) return;
+
+        account(lines[index], -1);
+        clearSlot(slot);
+
+        // Fill the gap with the last line
+        if (size_t(index) != lines.size() - 1)
+        {
+            slots[slotFor(lines.back().code)] = index;
+            lines[index] = lines.back();
+        }
+        lines.pop_back();
+        if (lines.empty())
+            subtotal = discountTotal = 0;
+    }
+
+    void clear()
+    {
+        lines.clear();
+        slots.assign(16, -1);
+        subtotal = discountTotal = 0;
+    }
+};
+
+// ======================================
+// Catalog Lock
+// ======================================
+// Readers-writer lock over the catalog: the product index, the secondary
+// indexes and every product field except stock. Sessions browsing,
+// filling carts and checking out share it, so they never wait on each
+// other; adding, editing or deleting products takes it exclusively, after
+// the admin has finished typing. Stock moves under the shared lock through
+// StockCounter.
+class CatalogLock
+{
+private:
+    pthread_rwlock_t lock;
+
+public:
+    CatalogLock() { pthread_rwlock_init(&lock, nullptr); }
+    ~CatalogLock() { pthread_rwlock_destroy(&lock); }
+
+    void lockShared() { pthread_rwlock_rdlock(&lock); }
+    void lockExclusive() { pthread_rwlock_wrlock(&lock); }
+    void unlock() { pthread_rwlock_unlock(&lock); }
+};
+
+struct ReadGuard
+{
+    CatalogLock &lock;
+    explicit ReadGuard(CatalogLock &catalogLock) : lock(catalogLock) { lock.lockShared(); }
+    ~ReadGuard() { lock.unlock(); }
+};
+
+struct WriteGuard
+{
+    CatalogLock &lock;
+    explicit WriteGuard(CatalogLock &catalogLock) : lock(catalogLock) { lock.lockExclusive(); }
+    ~WriteGuard() { lock.unlock(); }
+};
+
+// ======================================
+// Session
+// ======================================
+// One buyer's context: who is logged in and what is in their cart. Every
+// concurrent client has its own, used by one thread at a time; the console
+// menus use one too. Shopping keeps track of open sessions so deleting a
+// product can take it out of every cart, and so expired holds can be
+// taken out; both do that under the session's lock.
+struct Session
+{
+    Customer *customer;
+    bool admin;           // signed in with the admin credentials (requests only)
+    Cart cart;
+    mutex lock;           // the cart
+    size_t releasedLines; // lines whose hold expired, not yet reported
+
+    Session() : customer(nullptr), admin(false), releasedLines(0) {}
+};
+
+// ======================================
+// Operation Status
+// ======================================
+// Outcome of a shop operation. The console menus, the request dispatcher
+// and batch mode run the same operations and each words the outcome its
+// own way; requests answer with statusName().
+enum ShopStatus
+{
+    SHOP_OK,
+    SHOP_BAD_REQUEST,    // malformed or out-of-range arguments
+    SHOP_NOT_LOGGED_IN,
+    SHOP_NOT_ADMIN,
+    SHOP_BAD_LOGIN,
+    SHOP_USER_EXISTS,
+    SHOP_NO_PRODUCT,
+    SHOP_DUPLICATE,
+    SHOP_NOT_IN_CART,
+    SHOP_NO_STOCK,
+    SHOP_EMPTY_CART,
+    SHOP_UNAVAILABLE,    // the order ledger or customer database could not be opened
+    SHOP_STORAGE_ERROR   // a write failed; nothing was changed
+};
+
+const char *statusName(ShopStatus status)
+{
+    switch (status)
+    {
+    case SHOP_OK: return "ok";
+    case SHOP_BAD_REQUEST: return "bad-request";
+    case SHOP_NOT_LOGGED_IN: return "not-logged-in";
+    case SHOP_NOT_ADMIN: return "not-admin";
+    case SHOP_BAD_LOGIN: return "bad-login";
+    case SHOP_USER_EXISTS: return "user-exists";
+    case SHOP_NO_PRODUCT: return "no-product";
+    case SHOP_DUPLICATE: return "duplicate";
+    case SHOP_NOT_IN_CART: return "not-in-cart";
+    case SHOP_NO_STOCK: return "no-stock";
+    case SHOP_EMPTY_CART: return "empty-cart";
+    case SHOP_UNAVAILABLE: return "unavailable";
+    case SHOP_STORAGE_ERROR: return "storage-error";
+    }
+    return "unknown";
+}
+
+// What a cart operation did, for the caller to report
+struct CartChange
+{
+    string name;   // of the product
+    int quantity;  // now in the cart
+    int stockLeft; // in inventory afterwards, or when the units were refused
+    bool added;    // a new line rather than more of an existing one
+};
+
+// ======================================
+// Shopping Class
+// ======================================
+class Shopping
+{
+private:
+    ProductArena productArena;
+    ProductIndex productIndex;
+    CategoryIndex categoryIndex;
+    NameIndex nameIndex;
+    PriceIndex priceIndex;
+    StockIndex stockIndex;
+    CatalogAnalytics analytics;
+    LogWriter logWriter;
+    ProductJournal journal;
+    CatalogCheckpointer checkpointer;
+    unordered_set<int> dirtyCodes; // products changed since the last checkpoint
+    int checkpointSequence;
+    time_t lastCheckpoint;
+    SharedCatalog sharedCatalog;
+    uint64_t sharedSeen;      // last shared change applied here
+    uint64_t sharedStalledAt; // feed entry the last pull had to wait for
+    bool persisting;          // this process writes the catalog files
+    bool applyingShared;      // changes being applied came from other processes
+    CustomerRegistry customers;
+    CustomerStore customerStore;
+    OrderLedger orderLedger;
+    SalesRollups salesRollups;
+    ReservationWheel reservations;
+    thread expiryWorker;
+    mutex expiryMutex;
+    condition_variable expiryWakeup;
+    bool expiryStopping;
+
+    // Lock order: sharedMutex, then catalogLock, then sessionsMutex, then a
+    // session's lock, then any one of the mutexes below
+    mutex sharedMutex;    // pulls from the shared catalog
+    CatalogLock catalogLock;
+    mutex inventoryMutex; // stock index, analytics, journal and checkpoints
+    mutex customersMutex; // registry, customer store and wishlists
+    mutex ordersMutex;    // order ledger and sales rollups
+    mutex sessionsMutex;
+    unordered_set<Session *> sessions;
+    Session console;
+
+public:
+    Shopping() 
+        : checkpointSequence(0),
+          lastCheckpoint(time(nullptr)),
+          sharedSeen(0),
+          sharedStalledAt(0),
+          persisting(false),
+          applyingShared(false),
+          customerStore("customers.db"),
+          orderLedger("orders.ledger", "orders.heads"),
+          salesRollups(orderLedger),
+          expiryStopping(false)
+    {
+        sessions.insert(&console);
+    }
+
+    ~Shopping() { stopReservationExpiry(); }
+
+    // ---------- Sessions ----------
+    // A session must be open while its cart holds products
+    void openSession(Session &session);
+    void closeSession(Session &session);
+
+    // ---------- Requests (socket server, batch mode) ----------
+    // Runs one protocol request line for the session; the response is one
+    // or more newline-terminated lines. Without commit, what the request
+    // changed waits for the caller's next commitChanges(), which returns
+    // false if it could not be made durable.
+    ShopStatus execute(Session &session, const string &request, string &response, bool commit = true);
+    bool commitChanges();
+
+    // ---------- Main menus ----------
+    void menu();
+    void administrator();
+    void buyer();
+
+    // ---------- Admin login ----------
+    bool adminLogin();
+
+    // ---------- Administrator functionalities ----------
+    void addProduct();
+    void editProduct();
+    void deleteProduct();
+    void listProducts();
+    void listProductsByCategory();
+    void lowStockAlert();
+    void sortProductsByField(int field);
+    void createPromotion();
+    void viewAnalytics();
+    void queryAuditLog();
+
+    // ---------- Buyer functionalities ----------
+    void customerLogin(Session &session);
+    void customerRegistration(Session &session);
+    void customerLogout(Session &session);
+    void placeOrder(Session &session);
+    void viewOrderHistory(Session &session);
+    void addToWishlist(Session &session, int code);
+    void viewWishlist(Session &session);
+    void addToCart(Session &session, int code, int quantity);
+    void modifyCart(Session &session);
+    void displayCart(Session &session);
+
+    // ---------- Search functionalities ----------
+    void searchProductByName(string name);
+    void searchProductByPriceRange(float minPrice, float maxPrice, bool afterDiscount);
+
+    // ---------- Reports/Utilities ----------
+    void generateSalesReport();
+    void saveAllProducts();
+    void loadProductsOnStartup();
+
+    // ---------- Internal utility functions ----------
+private:
+    // Product index helpers
+    Product *findProduct(int code);
+    bool addProductToTree(Product *newProduct);
+    bool deleteProductFromTree(int code);
+    void indexProduct(Product *product);
+    void unindexProduct(Product *product);
+    void setDiscount(Product *product, float discount);
+    void setStock(Product *product, int stock);
+    void syncStock(Product *product);
+    void reportStockCrossing(const Product *product, int previousStock);
+
+    // Operations shared by the menus and the request dispatcher
+    ShopStatus signIn(Session &session, const string &username, const string &password);
+    ShopStatus signUp(Session &session, const string &username, const string &password);
+    void signOut(Session &session);
+    void switchCustomer(Session &session, Customer *customer);
+    ShopStatus reserveItems(Session &session, int code, int quantity, CartChange &change);
+    ShopStatus changeCartQuantity(Session &session, int code, int quantity, CartChange &change);
+    ShopStatus checkout(Session &session, uint64_t &orderId, float &totalCost, ostream *receipt);
+    ShopStatus createProduct(const Product &details);
+    ShopStatus updateProduct(int code, const string &name, float price, float discount, int stock,
+                             const string &category, Product &updated);
+    ShopStatus removeProduct(int code);
+    ShopStatus discountProduct(int code, float discount, string &name);
+
+    // Cart holds
+    void holdCartLine(Session &session, int code);
+    void releaseCart(Session &session);
+    void reportReleasedHolds(Session &session);
+    void expireReservations();
+    void runReservationExpiry();
+    void stopReservationExpiry();
+    template <typename Predicate, typename Action>
+    void visitProducts(Predicate matches, Action action);
+    template <typename Action>
+    void forEachProduct(Action action);
+    template <typename Action>
+    void forEachProductInCategory(const string &category, Action action);
+
+    void inOrderTraversal();
+    void inOrderTraversal(const string &filter, const string &filterType);
+    void inOrderTraversal(float minPrice, float maxPrice, bool afterDiscount);
+
+    // Binary snapshot / text import
+    vector<int> loadCatalogFiles();
+    bool loadSnapshot(const string &path);
+    bool saveSnapshot(const string &path);
+    bool applyDeltaFile(const string &path);
+    bool importProductsFromText(ifstream &file);
+
+    // Journal and checkpoint helpers
+    void applyJournalEntry(const JournalEntry &entry);
+    void recordProductUpsert(Product *product);
+    void recordProductDelete(int code);
+    void recordStockChange(const Product *product);
+    void recordDiscountChange(Product *product);
+    void captureCheckpoint();
+
+    // Catalog shared with other processes
+    void shareCatalog();
+    void joinSharedCatalog();
+    bool pullSharedChanges();
+    void applySharedRecord(const SharedRecord &record);
+    void adoptCatalogFiles();
+
+    // Customer data, loaded on first use
+    void loadWishlist(Customer *customer);
+    void checkAnalytics();
+
+    // Not strictly necessary here (used in your original code)
+    void saveProductStockToFile(ofstream &productFile, Product *root) {}
+};
+
+// ========== SESSIONS ==========
+void Shopping::openSession(Session &session)
+{
+    lock_guard<mutex> guard(sessionsMutex);
+    sessions.insert(&session);
+}
+
+// Whatever the session still holds goes back to stock
+void Shopping::closeSession(Session &session)
+{
+    {
+        ReadGuard catalog(catalogLock);
+        lock_guard<mutex> guard(sessionsMutex);
+        lock_guard<mutex> held(session.lock);
+        releaseCart(session);
+        sessions.erase(&session);
+    }
+    commitChanges();
+}
+
+// ========== CART HOLDS ==========
+// Starts the line's hold over, RESERVATION_TTL_SECONDS from now. Called
+// with the session's lock held whenever a line is added or changed.
+void Shopping::holdCartLine(Session &session, int code)
+{
+    const CartLine *line = session.cart.find(code);
+    if (!line)
+        return;
+    int64_t expiresAt = ReservationWheel::clock() + RESERVATION_TTL_SECONDS;
+    session.cart.setHold(code, reservations.renew(line->hold, &session, code, expiresAt));
+}
+
+// Gives every unit in the cart back to stock and empties it. Called with
+// the shared catalog lock and the session's lock held.
+void Shopping::releaseCart(Session &session)
+{
+    for (const CartLine &line : session.cart)
+    {
+        reservations.cancel(line.hold);
+        line.product->held.give(-line.quantity);
+        line.product->stock.give(line.quantity);
+        syncStock(line.product);
+    }
+    session.cart.clear();
+}
+
+void Shopping::reportReleasedHolds(Session &session)
+{
+    lock_guard<mutex> held(session.lock);
+    if (session.releasedLines == 0)
+        return;
+    cout << "Note: " << session.releasedLines << " item(s) were held in your cart for more than "
+         << RESERVATION_TTL_SECONDS / 60 << " minutes and went back to stock.\n";
+    session.releasedLines = 0;
+}
+
+// Returns the units of every hold that has come due. A line changed after
+// its hold fired has a new ticket and is left alone.
+void Shopping::expireReservations()
+{
+    vector<Reservation> expired;
+    {
+        ReadGuard catalog(catalogLock);
+        lock_guard<mutex> guard(sessionsMutex);
+        reservations.advance(ReservationWheel::clock(), expired);
+
+        for (const Reservation &reservation : expired)
+        {
+            if (!sessions.count(reservation.session))
+                continue;
+            Session &session = *reservation.session;
+            lock_guard<mutex> held(session.lock);
+            const CartLine *line = session.cart.find(reservation.code);
+            if (!line || line->hold.ticket != reservation.ticket)
+                continue;
+
+            Product *product = line->product;
+            product->held.give(-line->quantity);
+            product->stock.give(line->quantity);
+            session.cart.remove(reservation.code);
+            session.releasedLines++;
+            syncStock(product);
+        }
+    }
+
+    if (!expired.empty())
+        commitChanges();
+}
+
+// Background thread, woken once a second. The same tick picks up changes
+// other processes made to the shared catalog, and takes over the catalog
+// files if their owner is gone.
+void Shopping::runReservationExpiry()
+{
+    unique_lock<mutex> guard(expiryMutex);
+    while (!expiryStopping)
+    {
+        expiryWakeup.wait_for(guard, chrono::seconds(1));
+        if (expiryStopping)
+            break;
+        guard.unlock();
+        expireReservations();
+        if (pullSharedChanges())
+            commitChanges();
+        adoptCatalogFiles();
+        guard.lock();
+    }
+}
+
+void Shopping::stopReservationExpiry()
+{
+    {
+        lock_guard<mutex> guard(expiryMutex);
+        expiryStopping = true;
+        expiryWakeup.notify_one();
+    }
+    if (expiryWorker.joinable())
+        expiryWorker.join();
+}
+
+// ========== ADMIN LOGIN ==========
+const string ADMIN_USERNAME = "admin";
+const string ADMIN_PASSWORD = "admin123";
+
+bool Shopping::adminLogin()
+{
+    string username, password;
+    cout << "Enter admin username: ";
+    cin >> username;
+    cout << "Enter admin password: ";
+    cin >> password;
+
+    if (username == ADMIN_USERNAME && password == ADMIN_PASSWORD)
+    {
+        cout << "Admin login successful!\n";
+        return true;
+    }
+    else
+    {
+        cout << "Invalid admin credentials.\n";
+        return false;
+    }
+}
+
+// ========== FIND PRODUCT IN INDEX ==========
+Product *Shopping::findProduct(int code)
+{
+    return productIndex.find(code);
+}
+
+// ========== ADD PRODUCT TO INDEX ==========
+bool Shopping::addProductToTree(Product *newProduct)
+{
+    if (!productIndex.insert(newProduct))
+    {
+        cout << "Error: Duplicate product code. Product not added.\n";
+        return false;
+    }
+    indexProduct(newProduct);
+    return true;
+}
+
+// ========== DELETE PRODUCT FROM INDEX ==========
+bool Shopping::deleteProductFromTree(int code)
+{
+    Product *removed = productIndex.erase(code);
+    if (!removed)
+    {
+        cout << "Error: Product not found. Cannot delete.\n";
+        return false;
+    }
+    unindexProduct(removed);
+    {
+        // Units held in carts leave with the product
+        lock_guard<mutex> guard(sessionsMutex);
+        for (Session *session : sessions)
+        {
+            lock_guard<mutex> held(session->lock);
+            const CartLine *line = session->cart.find(code);
+            if (!line)
+                continue;
+            reservations.cancel(line->hold);
+            session->cart.remove(code);
+        }
+    }
+    productArena.release(removed);
+    return true;
+}
+
+// ========== SECONDARY INDEX MAINTENANCE ==========
+// Products entering or leaving the code index, or about to have their
+// fields edited, pass through these so secondary indexes stay in step.
+void Shopping::indexProduct(Product *product)
+{
+    product->bookedStock = product->stock;
+    categoryIndex.add(product);
+    nameIndex.add(product);
+    priceIndex.add(product);
+    stockIndex.add(product);
+    analytics.add(product);
+}
+
+void Shopping::unindexProduct(Product *product)
+{
+    analytics.remove(product);
+    categoryIndex.remove(product);
+    nameIndex.remove(product);
+    priceIndex.remove(product);
+    stockIndex.remove(product);
+}
+
+// A discount change moves the product only within the effective-price order
+// and changes its share of the analytics totals
+void Shopping::setDiscount(Product *product, float discount)
+{
+    priceIndex.remove(product);
+    analytics.remove(product);
+    product->discount = discount;
+    priceIndex.add(product);
+    analytics.add(product);
+}
+
+// Likewise a stock change only moves the product within the stock order
+void Shopping::setStock(Product *product, int stock)
+{
+    stockIndex.remove(product);
+    analytics.remove(product);
+    product->stock = stock;
+    product->bookedStock = stock;
+    stockIndex.add(product);
+    analytics.add(product);
+}
+
+// Live stock changes (not replay) also report threshold crossings.
+// Sessions move stock with compare-and-swap under the shared catalog lock.
+// This then books the counter's current value into the stock index,
+// analytics and journal. Each change is followed by a sync, so the last
+// sync always books the latest value.
+void Shopping::syncStock(Product *product)
+{
+    lock_guard<mutex> guard(inventoryMutex);
+    int previousStock = product->bookedStock;
+    int stock = product->stock;
+    if (stock != previousStock)
+    {
+        stockIndex.remove(product);
+        analytics.remove(product);
+        product->bookedStock = stock;
+        stockIndex.add(product);
+        analytics.add(product);
+        reportStockCrossing(product, previousStock);
+    }
+
+    // A sale changes the units held but not the stock on offer
+    recordStockChange(product);
+}
+
+// ========== LOW STOCK EVENTS ==========
+// Logged once when a product drops under LOW_STOCK_THRESHOLD and once when
+// it is restocked back over it, not on every change in between.
+void Shopping::reportStockCrossing(const Product *product, int previousStock)
+{
+    // The process that moved the stock reports it
+    if (applyingShared)
+        return;
+
+    bool wasLow = previousStock < LOW_STOCK_THRESHOLD;
+    bool isLow = product->bookedStock < LOW_STOCK_THRESHOLD;
+    if (wasLow == isLow)
+        return;
+
+    LogRecord logFile(logWriter, PRODUCT_LOG, LOG_OP_STOCK, product->code);
+    logFile << (isLow ? "Low Stock Event:\n" : "Restock Event:\n");
+    logFile << "Code: " << product->code << ", Name: " << product->name
+            << ", Stock: " << product->bookedStock << " (Threshold: " << LOW_STOCK_THRESHOLD << ")\n";
+    logFile << "---------------------------------------\n";
+    logFile.close();
+}
+
+// ========== VISIT PRODUCTS IN CODE ORDER ==========
+// Predicate and action are template parameters so the compiler can inline
+// them into the loop; the walk itself is iterative, so its depth does not
+// depend on catalog size.
+template <typename Predicate, typename Action>
+void Shopping::visitProducts(Predicate matches, Action action)
+{
+    for (Product *product : productIndex)
+    {
+        if (matches(product))
+            action(product);
+    }
+}
+
+template <typename Action>
+void Shopping::forEachProduct(Action action)
+{
+    for (Product *product : productIndex)
+        action(product);
+}
+
+// Walks one category's posting list instead of the whole catalog
+template <typename Action>
+void Shopping::forEachProductInCategory(const string &category, Action action)
+{
+    int id = categoryIndex.find(category);
+    if (id < 0) return;
+
+    for (Product *product : categoryIndex.productsIn(id))
+        action(product);
+}
+
+// ========== LOAD PRODUCTS ON STARTUP ==========
+// A process already running in this directory has the catalog in shared
+// memory, so later ones join it instead of reading the files. Startup is
+// serialized so two processes starting together do not both load them.
+void Shopping::loadProductsOnStartup()
+{
+    vector<int> deltaSequences;
+    sharedCatalog.beginStartup();
+    if (sharedCatalog.join())
+    {
+        joinSharedCatalog();
+    }
+    else
+    {
+        deltaSequences = loadCatalogFiles();
+        persisting = true;
+        shareCatalog();
+    }
+    sharedCatalog.endStartup();
+
+    checkpointer.start(deltaSequences);
+    logWriter.start();
+    expiryWorker = thread(&Shopping::runReservationExpiry, this);
+
+    if (!salesRollups.load())
+        cout << "Warning: Unable to load sales history. Sales reports will be empty.\n";
+
+    if (!productIndex.empty())
+        cout << "Products loaded successfully.\n";
+}
+
+// ========== LOAD THE CATALOG FILES ==========
+// Returns the delta files still to be merged
+vector<int> Shopping::loadCatalogFiles()
+{
+    // A handoff snapshot that was written in full replaces everything else
+    if (access(HANDOFF_SNAPSHOT_PATH, F_OK) == 0 && !finishCatalogHandoff())
+        cout << "Warning: Unable to finish taking over the catalog files.\n";
+
+    // Prefer the binary snapshot unless products.txt was edited after it
+    struct stat snapInfo, textInfo, journalInfo;
+    bool haveSnapshot = stat("products.snap", &snapInfo) == 0;
+    bool haveText = stat("products.txt", &textInfo) == 0;
+    bool fromSnapshot = false;
+    bool fromText = false;
+    struct timespec loadedFrom = {0, 0}; // modification time of the file the catalog came from
+
+    if (haveSnapshot && (!haveText || !laterThan(textInfo.st_mtim, snapInfo.st_mtim)))
+    {
+        fromSnapshot = loadSnapshot("products.snap");
+        if (fromSnapshot)
+            loadedFrom = snapInfo.st_mtim;
+        else
+            cout << "Warning: Product snapshot is unreadable. Importing products.txt instead.\n";
+    }
+
+    if (!fromSnapshot && haveText)
+    {
+        ifstream file("products.txt");
+        fromText = file && importProductsFromText(file);
+        file.close();
+        if (fromText)
+        {
+            loadedFrom = textInfo.st_mtim;
+        }
+        else
+        {
+            // Keep the edit for the user to repair instead of exporting
+            // over it, and carry on from the snapshot
+            rename("products.txt", "products.txt.rejected");
+            cout << "Warning: products.txt is unreadable and was moved to products.txt.rejected.\n";
+            if (haveSnapshot && (fromSnapshot = loadSnapshot("products.snap")))
+                loadedFrom = snapInfo.st_mtim;
+        }
+    }
+    else if (!fromSnapshot)
+    {
+        cout << "No product data file found. Starting with an empty inventory.\n";
+    }
+
+    // Find delta files and journal segments left by earlier checkpoints
+    set<int> sequences = checkpointFileSequences();
+    vector<int> deltaSequences;
+
+    // Replay them oldest first on top of the snapshot. When the catalog
+    // came from a hand-edited products.txt, anything older than that edit
+    // is stale and skipped.
+    auto applyEntry = [&](const JournalEntry &entry) { applyJournalEntry(entry); };
+    struct stat info;
+    for (int sequence : sequences)
+    {
+        checkpointSequence = max(checkpointSequence, sequence);
+        string segment = journalSegmentPath(sequence);
+        if (stat(segment.c_str(), &info) == 0 && (fromSnapshot || !laterThan(loadedFrom, info.st_mtim)))
+            ProductJournal::replayFile(segment, applyEntry);
+
+        string delta = deltaPath(sequence);
+        if (stat(delta.c_str(), &info) == 0 && (fromSnapshot || !laterThan(loadedFrom, info.st_mtim)))
+        {
+            if (applyDeltaFile(delta))
+                deltaSequences.push_back(sequence);
+            else
+                cout << "Warning: Ignoring unreadable checkpoint file " << delta << ".\n";
+        }
+    }
+
+    bool replay = stat("products.journal", &journalInfo) == 0
+               && (fromSnapshot || !laterThan(loadedFrom, journalInfo.st_mtim));
+    if (!journal.open("products.journal", replay, applyEntry))
+    {
+        cout << "Warning: Unable to open the product journal. Changes will not be saved.\n";
+    }
+
+    // Without a usable snapshot there is no base for deltas: write one now,
+    // once, and start the checkpoint chain over from it. Not when the
+    // catalog could be read from neither file, so nothing is replaced by it.
+    if (!fromSnapshot && (fromText || !haveText))
+    {
+        if (saveSnapshot("products.snap"))
+        {
+            for (int sequence : sequences)
+            {
+                remove(deltaPath(sequence).c_str());
+                remove(journalSegmentPath(sequence).c_str());
+            }
+            deltaSequences.clear();
+            journal.reset();
+        }
+        else
+        {
+            cout << "Error: Unable to save product snapshot.\n";
+        }
+    }
+    return deltaSequences;
+}
+
+// ========== IMPORT PRODUCTS FROM TEXT FILE ==========
+// Nothing is added unless every line reads back, so a file that was cut
+// short or edited into a bad shape never replaces the catalog with part
+// of it. Returns false in that case.
+bool Shopping::importProductsFromText(ifstream &file)
+{
+    vector<Product *> products;
+    string line;
+    size_t lineNumber = 0;
+    bool valid = true;
+    while (valid && getline(file, line))
+    {
+        lineNumber++;
+        if (!line.empty() && line[line.size() - 1] == '\r')
+            line.erase(line.size() - 1);
+        if (line.find_first_not_of(" \t") == string::npos)
+            continue;
+
+        Product *newProduct = productArena.allocate();
+        newProduct->left = nullptr;
+        products.push_back(newProduct);
+        if (!parseProductLine(line, *newProduct))
+        {
+            cout << "Error: Line " << lineNumber << " of products.txt is not a valid product.\n";
+            valid = false;
+        }
+    }
+
+    if (!valid || file.bad())
+    {
+        for (Product *product : products)
+            productArena.release(product);
+        return false;
+    }
+    for (Product *product : products)
+    {
+        if (!addProductToTree(product))
+            productArena.release(product);
+    }
+    return true;
+}
+
+// ========== LOAD BINARY SNAPSHOT ==========
+bool Shopping::loadSnapshot(const string &path)
+{
+    vector<Product *> products;
+    bool valid = readCatalogFile(path, SNAPSHOT_MAGIC,
+        [&](const SnapshotRecord &record, const char *heap)
+        {
+            Product *product = productArena.allocate();
+            product->code = record.code;
+            product->name.assign(heap + record.nameOffset, record.nameLength);
+            product->price = record.price;
+            product->discount = record.discount;
+            product->stock = record.stock;
+            product->category.assign(heap + record.categoryOffset, record.categoryLength);
+            product->left = nullptr;
+            products.push_back(product);
+        }, nullptr);
+
+    if (!valid)
+    {
+        for (Product *product : products)
+            productArena.release(product);
+        return false;
+    }
+
+    // Records are already sorted by code, so the index is built in one pass
+    productIndex.bulkLoad(products.data(), int(products.size()));
+    for (Product *product : products)
+        indexProduct(product);
+    return true;
+}
+
+// ========== SAVE BINARY SNAPSHOT ==========
+bool Shopping::saveSnapshot(const string &path)
+{
+    vector<const Product *> products;
+    products.reserve(productIndex.count());
+    forEachProduct([&](const Product *product) { products.push_back(product); });
+    return writeCatalogFile(path, SNAPSHOT_MAGIC, products, nullptr);
+}
+
+// ========== APPLY A CHECKPOINT DELTA DURING STARTUP ==========
+bool Shopping::applyDeltaFile(const string &path)
+{
+    vector<int> deletes;
+    bool valid = readCatalogFile(path, DELTA_MAGIC,
+        [&](const SnapshotRecord &record, const char *heap)
+        {
+            JournalEntry entry;
+            entry.type = JOURNAL_UPSERT;
+            entry.code = record.code;
+            entry.name.assign(heap + record.nameOffset, record.nameLength);
+            entry.price = record.price;
+            entry.discount = record.discount;
+            entry.stock = record.stock;
+            entry.category.assign(heap + record.categoryOffset, record.categoryLength);
+            applyJournalEntry(entry);
+        }, &deletes);
+
+    for (int code : deletes)
+    {
+        if (findProduct(code))
+            deleteProductFromTree(code);
+    }
+    return valid;
+}
+
+// ========== APPLY A JOURNAL RECORD DURING REPLAY ==========
+void Shopping::applyJournalEntry(const JournalEntry &entry)
+{
+    Product *product = findProduct(entry.code);
+    switch (entry.type)
+    {
+    case JOURNAL_UPSERT:
+        if (product)
+        {
+            unindexProduct(product);
+        }
+        else
+        {
+            product = productArena.allocate();
+            product->code = entry.code;
+            product->left = nullptr;
+            productIndex.insert(product);
+        }
+        product->name = entry.name;
+        product->price = entry.price;
+        product->discount = entry.discount;
+        product->stock = entry.stock;
+        product->category = entry.category;
+        indexProduct(product);
+        break;
+    case JOURNAL_DELETE:
+        if (product)
+            deleteProductFromTree(entry.code);
+        break;
+    case JOURNAL_STOCK:
+        if (product)
+            setStock(product, entry.stock);
+        break;
+    case JOURNAL_DISCOUNT:
+        if (product)
+            setDiscount(product, entry.discount);
+        break;
+    }
+}
+
+// ========== RECORD A MUTATION ==========
+// Every change is journaled for durability and remembered as dirty so
+// the next checkpoint copies just the products that actually changed.
+// Only the process that owns the catalog files journals. Changes made in
+// this process are also published to the shared catalog.
+void Shopping::recordProductUpsert(Product *product)
+{
+    if (persisting)
+    {
+        journal.logUpsert(product);
+        dirtyCodes.insert(product->code);
+    }
+    if (!applyingShared && !sharedCatalog.store(product))
+        cout << "Error: The shared catalog is full. Other processes will not see this change.\n";
+}
+
+void Shopping::recordProductDelete(int code)
+{
+    if (persisting)
+    {
+        journal.logDelete(code);
+        dirtyCodes.insert(code);
+    }
+    if (!applyingShared)
+        sharedCatalog.erase(code);
+}
+
+// The counter itself is shared, so other processes only need telling
+void Shopping::recordStockChange(const Product *product)
+{
+    if (persisting)
+    {
+        journal.logStock(product->code, shelfStock(*product));
+        dirtyCodes.insert(product->code);
+    }
+    if (!applyingShared)
+        sharedCatalog.announce(product->code);
+}
+
+void Shopping::recordDiscountChange(Product *product)
+{
+    if (persisting)
+    {
+        journal.logDiscount(product->code, product->discount);
+        dirtyCodes.insert(product->code);
+    }
+    if (!applyingShared)
+        sharedCatalog.store(product);
+}
+
+// ========== COMMIT JOURNALED CHANGES ==========
+// Called once per menu action, so every change an action made is
+// persisted together with a single write and sync. Periodically (or when
+// the journal grows large) the dirty products are handed to the
+// background checkpointer. Returns false if the journal could not be
+// written or synced.
+bool Shopping::commitChanges()
+{
+    {
+        ReadGuard catalog(catalogLock);
+        lock_guard<mutex> guard(inventoryMutex);
+        if (!journal.write())
+            return false;
+
+        if (!dirtyCodes.empty()
+            && (time(nullptr) - lastCheckpoint >= CHECKPOINT_INTERVAL_SECONDS
+                || journal.size() >= JOURNAL_CHECKPOINT_BYTES))
+        {
+            captureCheckpoint();
+        }
+    }
+
+    // Outside the inventory lock, so other sessions keep reserving stock
+    // while this one waits for the disk
+    return journal.sync();
+}
+
+// ========== CAPTURE DIRTY PRODUCTS FOR THE CHECKPOINTER ==========
+// Costs O(changed products) on this thread; the file I/O happens in the
+// background.
+void Shopping::captureCheckpoint()
+{
+    CheckpointBatch batch;
+    batch.sequence = checkpointSequence + 1;
+    if (!journal.rotate(journalSegmentPath(batch.sequence)))
+    {
+        cout << "Error: Unable to rotate the product journal.\n";
+        return;
+    }
+    checkpointSequence = batch.sequence;
+
+    vector<int> codes(dirtyCodes.begin(), dirtyCodes.end());
+    sort(codes.begin(), codes.end());
+    batch.upserts.reserve(codes.size());
+    for (int code : codes)
+    {
+        Product *product = findProduct(code);
+        if (product)
+        {
+            batch.upserts.push_back(*product);
+            batch.upserts.back().left = nullptr;
+        }
+        else
+        {
+            batch.deletes.push_back(code);
+        }
+    }
+
+    dirtyCodes.clear();
+    lastCheckpoint = time(nullptr);
+    checkpointer.submit(batch);
+}
+
+// ========== SAVE ALL PRODUCTS ==========
+// Every change is already durable in the journal, so exiting only has to
+// give back the units still held in carts, flush the journal and let any
+// checkpoint in progress finish. Changes other processes made to the
+// shared catalog are pulled in first, and if nobody owns the catalog
+// files any more this process saves them before it leaves.
+void Shopping::saveAllProducts()
+{
+    stopReservationExpiry();
+    {
+        ReadGuard catalog(catalogLock);
+        lock_guard<mutex> guard(sessionsMutex);
+        for (Session *session : sessions)
+        {
+            lock_guard<mutex> held(session->lock);
+            releaseCart(*session);
+        }
+    }
+
+    // Other processes leave one at a time. Once the rest are gone, this
+    // pull is the last look at the change ring, and the files are taken
+    // over if their owner has gone too, so nothing is lost with the segment.
+    sharedCatalog.beginStartup();
+    pullSharedChanges();
+    adoptCatalogFiles();
+    bool committed = journal.commit();
+    checkpointer.stop();
+
+    // The process that keeps the catalog files leaves the export current
+    if (persisting)
+    {
+        ReadGuard catalog(catalogLock);
+        vector<const Product *> products;
+        products.reserve(productIndex.count());
+        forEachProduct([&](const Product *product) { products.push_back(product); });
+        if (!exportProducts(products))
+            cout << "Warning: Unable to export products.txt.\n";
+    }
+    sharedCatalog.leave();
+    sharedCatalog.endStartup();
+    logWriter.stop();
+
+    if (committed)
+        cout << "Product data saved successfully.\n";
+}
+
+// ========== SHARE THE CATALOG ==========
+// The process that loaded the files creates the shared segment; from then
+// on every product's stock is the shared counter
+void Shopping::shareCatalog()
+{
+    vector<Product *> products;
+    products.reserve(productIndex.count());
+    forEachProduct([&](Product *product) { products.push_back(product); });
+    if (!sharedCatalog.create(products))
+        cout << "Warning: Unable to share the catalog with other processes.\n";
+}
+
+// ========== JOIN THE SHARED CATALOG ==========
+// Copies the products out of the segment and builds the local indexes in
+// one pass, like loading a snapshot. Stock is not copied: each product
+// uses its shared counter.
+void Shopping::joinSharedCatalog()
+{
+    sharedSeen = sharedCatalog.sequence();
+    vector<Product *> products;
+    sharedCatalog.forEach([&](const SharedRecord &record)
+    {
+        Product *product = productArena.allocate();
+        product->code = record.code;
+        product->name = record.name;
+        product->price = record.price;
+        product->discount = record.discount;
+        product->stock.attach(record.stock);
+        product->held.attach(record.held);
+        product->category = record.category;
+        product->left = nullptr;
+        products.push_back(product);
+    });
+
+    sort(products.begin(), products.end(),
+         [](const Product *a, const Product *b) { return a->code < b->code; });
+    productIndex.bulkLoad(products.data(), int(products.size()));
+    for (Product *product : products)
+        indexProduct(product);
+}
+
+// ========== PULL CHANGES FROM OTHER PROCESSES ==========
+// Re-reads the products other processes announced since the last pull
+// and updates the local indexes; the owner of the catalog files journals
+// them too. Announcements from this process are skipped without taking the
+// catalog lock. A process that fell too far behind copies every product
+// instead. Returns whether anything was applied.
+bool Shopping::pullSharedChanges()
+{
+    if (!sharedCatalog.attached())
+        return false;
+    lock_guard<mutex> guard(sharedMutex);
+
+    vector<int> codes;
+    bool stalled;
+    uint64_t seen = sharedSeen;
+    bool complete = sharedCatalog.changesSince(seen, codes, stalled);
+
+    // An entry left half-written by a process that died would hold the
+    // feed up forever, so a second wait on the same entry copies everything
+    if (stalled && sharedStalledAt == seen + 1)
+        complete = false;
+    sharedStalledAt = stalled ? seen + 1 : 0;
+    if (complete && codes.empty())
+    {
+        sharedSeen = seen;
+        return false;
+    }
+
+    WriteGuard catalog(catalogLock);
+    applyingShared = true;
+    if (complete)
+    {
+        sort(codes.begin(), codes.end());
+        codes.erase(unique(codes.begin(), codes.end()), codes.end());
+        SharedRecord record;
+        for (int code : codes)
+        {
+            sharedCatalog.read(code, record);
+            applySharedRecord(record);
+        }
+        sharedSeen = seen;
+    }
+    else
+    {
+        uint64_t last = sharedCatalog.sequence();
+        vector<SharedRecord> records;
+        sharedCatalog.forEach([&](const SharedRecord &record) { records.push_back(record); });
+
+        unordered_set<int> live;
+        for (const SharedRecord &record : records)
+        {
+            live.insert(record.code);
+            applySharedRecord(record);
+        }
+
+        SharedRecord gone;
+        gone.live = false;
+        vector<int> removed;
+        forEachProduct([&](const Product *product)
+        {
+            if (!live.count(product->code))
+                removed.push_back(product->code);
+        });
+        for (int code : removed)
+        {
+            gone.code = code;
+            applySharedRecord(gone);
+        }
+        sharedSeen = last;
+        sharedStalledAt = 0;
+    }
+    applyingShared = false;
+    return true;
+}
+
+// Brings the local product in line with its shared record. With the
+// catalog lock held exclusively.
+void Shopping::applySharedRecord(const SharedRecord &record)
+{
+    Product *product = findProduct(record.code);
+    if (!record.live)
+    {
+        if (product)
+        {
+            deleteProductFromTree(record.code);
+            recordProductDelete(record.code);
+        }
+        return;
+    }
+
+    bool added = !product;
+    if (added)
+    {
+        product = productArena.allocate();
+        product->code = record.code;
+        product->left = nullptr;
+    }
+    else if (product->name == record.name && product->price == record.price
+             && product->discount == record.discount && product->category == record.category)
+    {
+        // Only the stock can have changed
+        syncStock(product);
+        return;
+    }
+    else
+    {
+        unindexProduct(product);
+    }
+
+    product->name = record.name;
+    product->price = record.price;
+    product->discount = record.discount;
+    product->category = record.category;
+    product->stock.attach(record.stock);
+    product->held.attach(record.held);
+    if (added)
+        productIndex.insert(product);
+    indexProduct(product);
+    recordProductUpsert(product);
+}
+
+// ========== TAKE OVER THE CATALOG FILES ==========
+// When the owner of the catalog files has exited or died, the next process
+// to notice takes over. It starts the files over from a snapshot of its
+// catalog, which already holds every shared change, including any the old
+// owner never journaled. The snapshot is complete on disk before any old
+// file goes, and a crash in between is finished at the next startup.
+void Shopping::adoptCatalogFiles()
+{
+    if (persisting || !sharedCatalog.claim())
+        return;
+    pullSharedChanges();
+
+    lock_guard<mutex> guard(sharedMutex);
+    WriteGuard catalog(catalogLock);
+    lock_guard<mutex> inventory(inventoryMutex);
+    if (!saveSnapshot(HANDOFF_SNAPSHOT_PATH) || !finishCatalogHandoff())
+    {
+        cout << "Error: Unable to save product snapshot. Changes will not be saved.\n";
+        return;
+    }
+    if (!journal.open("products.journal", false, [](const JournalEntry &) {}))
+        cout << "Warning: Unable to open the product journal. Changes will not be saved.\n";
+
+    checkpointSequence = 0;
+    dirtyCodes.clear();
+    lastCheckpoint = time(nullptr);
+    persisting = true;
+}
+
+// ========== ADMIN METHODS ==========
+
+// -------------- ADD PRODUCT --------------
+void Shopping::addProduct()
+{
+    Product newProduct;
+
+    cout << "Enter Product Code: ";
+    cin >> newProduct.code;
+
+    if (cin.fail() || newProduct.code <= 0)
+    {
+        cout << "Invalid Product Code! Code must be a positive integer.\n";
+        cin.clear();
+        cin.ignore(10000, '\n');
+        return;
+    }
+
+    // Check for duplicate
+    bool duplicate;
+    {
+        ReadGuard catalog(catalogLock);
+        duplicate = findProduct(newProduct.code) != nullptr;
+    }
+    if (duplicate)
+    {
+        cout << "Error: Product code already exists. Cannot add duplicate product.\n";
+        return;
+    }
+
+    // Product Name
+    cout << "Enter Product Name: ";
+    cin.ignore();
+    getline(cin, newProduct.name);
+
+    if (newProduct.name.empty())
+    {
+        cout << "Invalid Product Name! Name cannot be empty.\n";
+        return;
+    }
+
+    // Price
+    cout << "Enter Product Price: ";
+    cin >> newProduct.price;
+    if (cin.fail() || newProduct.price <= 0)
+    {
+        cout << "Invalid Product Price! Price must be a positive number.\n";
+        cin.clear();
+        cin.ignore(10000, '\n');
+        return;
+    }
+
+    // Discount
+    cout << "Enter Discount Percentage (0-100): ";
+    cin >> newProduct.discount;
+    if (cin.fail() || newProduct.discount < 0 || newProduct.discount > 100)
+    {
+        cout << "Invalid Discount! Must be between 0 and 100.\n";
+        cin.clear();
+        cin.ignore(10000, '\n');
+        return;
+    }
+
+    // Stock
+    cout << "Enter Stock Quantity: ";
+    cin >> newProduct.stock;
+    if (cin.fail() || newProduct.stock < 0)
+    {
+        cout << "Invalid Stock Quantity! Stock cannot be negative.\n";
+        cin.clear();
+        cin.ignore(10000, '\n');
+        return;
+    }
+
+    // Category
+    cout << "Enter Product Category: ";
+    cin.ignore();
+    getline(cin, newProduct.category);
+    if (newProduct.category.empty())
+    {
+        cout << "Invalid Category! Category cannot be empty.\n";
+        return;
+    }
+
+    // Insert into the product index, unless the code was taken while the
+    // details were being entered
+    ShopStatus status = createProduct(newProduct);
+    if (status == SHOP_STORAGE_ERROR)
+    {
+        cout << "Error: The shared catalog is full. Product not added.\n";
+        return;
+    }
+    if (status != SHOP_OK)
+    {
+        cout << "Error: Duplicate product code. Product not added.\n";
+        return;
+    }
+
+    cout << "Product added successfully!\n";
+    cout << "---------------------------\n";
+    cout << "Code: " << newProduct.code << "\n";
+    cout << "Name: " << newProduct.name << "\n";
+    cout << "Price: $" << newProduct.price << "\n";
+    cout << "Discount: " << newProduct.discount << "%\n";
+    cout << "Stock: " << newProduct.stock << "\n";
+    cout << "Category: " << newProduct.category << "\n";
+}
+
+// Validates the details, then adds a copy to the catalog, journals it and
+// logs it
+ShopStatus Shopping::createProduct(const Product &details)
+{
+    if (details.code <= 0 || details.name.empty() || !(details.price > 0)
+        || !(details.discount >= 0 && details.discount <= 100) || details.stock < 0 || details.category.empty())
+        return SHOP_BAD_REQUEST;
+
+    WriteGuard catalog(catalogLock);
+    if (findProduct(details.code))
+        return SHOP_DUPLICATE;
+    if (!sharedCatalog.hasRoom(details.code, details.name, details.category))
+        return SHOP_STORAGE_ERROR;
+
+    Product *newProduct = productArena.allocate();
+    newProduct->code = details.code;
+    newProduct->name = details.name;
+    newProduct->price = details.price;
+    newProduct->discount = details.discount;
+    newProduct->stock = int(details.stock);
+    newProduct->category = details.category;
+    newProduct->left = nullptr;
+    addProductToTree(newProduct);
+    recordProductUpsert(newProduct);
+
+    // Log to file
+    LogRecord logFile(logWriter, PRODUCT_LOG, LOG_OP_ADD, newProduct->code);
+    logFile << "Product Added:\n";
+    logFile << "Code: " << newProduct->code << "\n";
+    logFile << "Name: " << newProduct->name << "\n";
+    logFile << "Price: $" << newProduct->price << "\n";
+    logFile << "Discount: " << newProduct->discount << "%\n";
+    logFile << "Stock: " << newProduct->stock << "\n";
+    logFile << "Category: " << newProduct->category << "\n";
+    logFile << "---------------------------------------\n";
+    logFile.close();
+
+    reportStockCrossing(newProduct, LOW_STOCK_THRESHOLD);
+    return SHOP_OK;
+}
+
+// -------------- EDIT PRODUCT --------------
+void Shopping::editProduct()
+{
+    int code;
+    cout << "Enter the Product Code to edit: ";
+    cin >> code;
+
+    {
+        ReadGuard catalog(catalogLock);
+        Product *product = findProduct(code);
+        if (!product)
+        {
+            cout << "Product not found.\n";
+            return;
+        }
+
+        cout << "\nEditing Product: " << product->name << "\n";
+        cout << "---------------------------------------\n";
+        cout << "Existing Details:\n";
+        cout << "Code: " << product->code << "\n";
+        cout << "Name: " << product->name << "\n";
+        cout << "Price: $" << product->price << "\n";
+        cout << "Discount: " << product->discount << "%\n";
+        cout << "Stock: " << product->stock << "\n";
+        cout << "Category: " << product->category << "\n";
+        cout << "---------------------------------------\n";
+    }
+
+    // Every new value is read before the catalog is locked
+    cout << "Enter New Name (leave empty to keep existing): ";
+    cin.ignore();
+    string newName;
+    getline(cin, newName);
+
+    cout << "Enter New Price (-1 to keep existing): ";
+    float newPrice;
+    cin >> newPrice;
+
+    cout << "Enter New Discount Percentage (0-100, -1 to keep existing): ";
+    float newDiscount;
+    cin >> newDiscount;
+
+    cout << "Enter New Stock Quantity (-1 to keep existing): ";
+    int newStock;
+    cin >> newStock;
+
+    cout << "Enter New Category (leave empty to keep existing): ";
+    cin.ignore();
+    string newCategory;
+    getline(cin, newCategory);
+
+    Product product;
+    ShopStatus status = updateProduct(code, newName, newPrice, newDiscount, newStock, newCategory, product);
+    if (status == SHOP_STORAGE_ERROR)
+    {
+        cout << "Error: The shared catalog is full. Product not updated.\n";
+        return;
+    }
+    if (status != SHOP_OK)
+    {
+        cout << "Product not found.\n";
+        return;
+    }
+
+    cout << "Product updated successfully!\n";
+    cout << "---------------------------------------\n";
+    cout << "Updated Details:\n";
+    cout << "Code: " << product.code << "\n";
+    cout << "Name: " << product.name << "\n";
+    cout << "Price: $" << product.price << "\n";
+    cout << "Discount: " << product.discount << "%\n";
+    cout << "Stock: " << product.stock << "\n";
+    cout << "Category: " << product.category << "\n";
+    cout << "---------------------------------------\n";
+}
+
+// Empty strings, negative numbers and discounts over 100 keep the existing
+// value. The product as edited is copied into updated.
+ShopStatus Shopping::updateProduct(int code, const string &name, float price, float discount, int stock,
+                                   const string &category, Product &updated)
+{
+    WriteGuard catalog(catalogLock);
+    Product *product = findProduct(code);
+    if (!product)
+        return SHOP_NO_PRODUCT;
+    if (!sharedCatalog.hasRoom(code, name, category))
+        return SHOP_STORAGE_ERROR;
+
+    // Pull the product out of secondary indexes while its fields change
+    int previousStock = product->bookedStock;
+    unindexProduct(product);
+    if (!name.empty())
+        product->name = name;
+    if (price >= 0)
+        product->price = price;
+    if (discount >= 0 && discount <= 100)
+        product->discount = discount;
+    if (stock >= 0)
+        product->stock = stock;
+    if (!category.empty())
+        product->category = category;
+    indexProduct(product);
+    recordProductUpsert(product);
+    updated = *product;
+
+    // Log
+    LogRecord logFile(logWriter, PRODUCT_LOG, LOG_OP_EDIT, product->code);
+    logFile << "Product Edited:\n";
+    logFile << "Code: " << product->code << "\n";
+    logFile << "Name: " << product->name << "\n";
+    logFile << "Price: $" << product->price << "\n";
+    logFile << "Discount: " << product->discount << "%\n";
+    logFile << "Stock: " << product->stock << "\n";
+    logFile << "Category: " << product->category << "\n";
+    logFile << "---------------------------------------\n";
+    logFile.close();
+
+    reportStockCrossing(product, previousStock);
+    return SHOP_OK;
+}
+
+// -------------- DELETE PRODUCT --------------
+void Shopping::deleteProduct()
+{
+    int code;
+    cout << "Enter the Product Code to delete: ";
+    cin >> code;
+
+    // First check
+    {
+        ReadGuard catalog(catalogLock);
+        Product *product = findProduct(code);
+        if (!product)
+        {
+            cout << "Product not found.\n";
+            return;
+        }
+
+        cout << "\nProduct Details:\n";
+        cout << "---------------------------------------\n";
+        cout << "Code: " << product->code << "\n";
+        cout << "Name: " << product->name << "\n";
+        cout << "Price: $" << product->price << "\n";
+        cout << "Discount: " << product->discount << "%\n";
+        cout << "Stock: " << product->stock << "\n";
+        cout << "Category: " << product->category << "\n";
+        cout << "---------------------------------------\n";
+    }
+
+    char confirm;
+    cout << "Are you sure you want to delete this product? (Y/N): ";
+    cin >> confirm;
+    if (tolower(confirm) != 'y')
+    {
+        cout << "Product deletion canceled.\n";
+        return;
+    }
+
+    if (removeProduct(code) != SHOP_OK)
+    {
+        cout << "Error: Product not found. Cannot delete.\n";
+        return;
+    }
+    cout << "Product deleted successfully!\n";
+}
+
+ShopStatus Shopping::removeProduct(int code)
+{
+    {
+        WriteGuard catalog(catalogLock);
+        if (!findProduct(code))
+            return SHOP_NO_PRODUCT;
+        deleteProductFromTree(code);
+        recordProductDelete(code);
+    }
+
+    // Log
+    LogRecord logFile(logWriter, PRODUCT_LOG, LOG_OP_DELETE, code);
+    logFile << "Product Deleted:\n";
+    logFile << "Code: " << code << "\n";
+    logFile << "---------------------------------------\n";
+    logFile.close();
+    return SHOP_OK;
+}
+
+// -------------- LIST ALL PRODUCTS --------------
+// The catalog in memory is the whole inventory; the export can lag it
+void Shopping::listProducts()
+{
+    ReadGuard catalog(catalogLock);
+    if (productIndex.empty())
+    {
+        cout << "No products available to list.\n";
+        return;
+    }
+
+    cout << "===================================================================\n";
+    cout << "Code\tName\t\tPrice\tDiscount\tStock\tCategory\n";
+    cout << "===================================================================\n";
+    inOrderTraversal();
+    cout << "===================================================================\n";
+}
+
+// -------------- LIST PRODUCTS BY CATEGORY --------------
+void Shopping::listProductsByCategory()
+{
+    ReadGuard catalog(catalogLock);
+    if (productIndex.empty())
+    {
+        cout << "No products available.\n";
+        return;
+    }
+
+    cout << "Enter the category to list products: ";
+    cin.ignore();
+    string category;
+    getline(cin, category);
+
+    cout << "\nProducts in Category: " << category << "\n";
+    cout << "===================================================================\n";
+    cout << "Code\tName\t\tPrice\tDiscount\tStock\n";
+    cout << "===================================================================\n";
+
+    // Visit the category's products in code order
+    forEachProductInCategory(category, [&](const Product *product)
+    {
+        cout << product->code << "\t" << product->name << "\t\t$" << product->price
+             << "\t" << product->discount << "%\t\t" << product->stock << "\n";
+    });
+
+    cout << "===================================================================\n";
+
+    // Log
+    LogRecord logFile(logWriter, PRODUCT_LOG, LOG_OP_REPORT);
+    logFile << "Listed Products by Category: " << category << "\n";
+    logFile << "---------------------------------------\n";
+    logFile.close();
+}
+
+// -------------- LOW STOCK ALERT --------------
+void Shopping::lowStockAlert()
+{
+    ReadGuard catalog(catalogLock);
+    if (productIndex.empty())
+    {
+        cout << "No products available.\n";
+        return;
+    }
+
+    int threshold;
+    cout << "Enter the stock threshold for alert: ";
+    cin >> threshold;
+
+    lock_guard<mutex> guard(inventoryMutex);
+    cout << "\nLow Stock Products (Stock < " << threshold << "):\n";
+    cout << "===================================================================\n";
+    cout << "Code\tName\t\tPrice\tDiscount\tStock\tCategory\n";
+    cout << "===================================================================\n";
+
+    stockIndex.forEachBelow(threshold, [&](const Product *product)
+    {
+        cout << product->code << "\t" << product->name << "\t\t$" << product->price
+             << "\t" << product->discount << "%\t\t" << product->stock
+             << "\t" << product->category << "\n";
+    });
+
+    cout << "===================================================================\n";
+
+    // Log
+    LogRecord logFile(logWriter, PRODUCT_LOG, LOG_OP_REPORT);
+    logFile << "Generated Low Stock Alert (Threshold: " << threshold << "):\n";
+    logFile << "---------------------------------------\n";
+    logFile.close();
+}
+
+// -------------- SORT PRODUCTS BY FIELD --------------
+void Shopping::sortProductsByField(int field)
+{
+    ReadGuard catalog(catalogLock);
+    if (productIndex.empty())
+    {
+        cout << "No products available to sort.\n";
+        return;
+    }
+
+    // Collect all products into a vector
+    vector<Product*> products;
+    products.reserve(productIndex.count());
+    forEachProduct([&](Product *product)
+    {
+        products.push_back(product);
+    });
+
+    // Sort based on field
+    switch (field)
+    {
+    case 1: // Name
+        sort(products.begin(), products.end(), 
+            [](Product *a, Product *b){ return a->name < b->name; });
+        break;
+    case 2: // Price
+        sort(products.begin(), products.end(), 
+            [](Product *a, Product *b){ return a->price < b->price; });
+        break;
+    case 3: // Stock
+        sort(products.begin(), products.end(), 
+            [](Product *a, Product *b){ return a->stock < b->stock; });
+        break;
+    default:
+        cout << "Invalid sorting field. Please choose 1 (Name), 2 (Price), or 3 (Stock).\n";
+        return;
+    }
+
+    // Display sorted
+    cout << "\nSorted Products:\n";
+    cout << "===================================================================\n";
+    cout << "Code\tName\t\tPrice\tDiscount\tStock\tCategory\n";
+    cout << "===================================================================\n";
+
+    for (auto product : products)
+    {
+        cout << product->code << "\t" << product->name << "\t\t$" << product->price
+             << "\t" << product->discount << "%\t\t" << product->stock
+             << "\t" << product->category << "\n";
+    }
+    cout << "===================================================================\n";
+
+    // Log
+    LogRecord logFile(logWriter, PRODUCT_LOG, LOG_OP_REPORT);
+    logFile << "Sorted Products by Field (" << field << "):\n";
+    for (auto product : products)
+    {
+        logFile << "Code: " << product->code
+                << ", Name: " << product->name
+                << ", Price: $" << product->price
+                << ", Stock: " << product->stock
+                << ", Category: " << product->category << "\n";
+    }
+    logFile << "---------------------------------------\n";
+    logFile.close();
+}
+
+// -------------- CREATE PROMOTION --------------
+void Shopping::createPromotion()
+{
+    int promotionType;
+    cout << "Create Promotion:\n";
+    cout << "1) Discount on a Specific Product\n";
+    cout << "2) Discount on a Category\n";
+    cout << "3) General Discount on All Products\n";
+    cout << "Enter your choice: ";
+    cin >> promotionType;
+
+    if (promotionType < 1 || promotionType > 3)
+    {
+        cout << "Invalid choice. Please select 1, 2, or 3.\n";
+        return;
+    }
+
+    switch (promotionType)
+    {
+    case 1:
+    {
+        // Specific Product
+        int code;
+        float discount;
+        cout << "Enter Product Code: ";
+        cin >> code;
+        cout << "Enter Discount Percentage (0-100): ";
+        cin >> discount;
+
+        string name;
+        ShopStatus status = discountProduct(code, discount, name);
+        if (status == SHOP_BAD_REQUEST)
+        {
+            cout << "Invalid discount percentage. Must be between 0 and 100.\n";
+            return;
+        }
+        if (status == SHOP_NO_PRODUCT)
+        {
+            cout << "Product not found.\n";
+            return;
+        }
+        cout << "Discount of " << discount << "% applied to product: " << name << "\n";
+        break;
+    }
+    case 2:
+    {
+        // Category
+        string category;
+        float discount;
+        cout << "Enter Category: ";
+        cin.ignore();
+        getline(cin, category);
+        cout << "Enter Discount Percentage (0-100): ";
+        cin >> discount;
+        if (discount < 0 || discount > 100)
+        {
+            cout << "Invalid discount percentage. Must be between 0 and 100.\n";
+            return;
+        }
+
+        WriteGuard catalog(catalogLock);
+        forEachProductInCategory(category, [&](Product *product)
+        {
+            setDiscount(product, discount);
+            recordDiscountChange(product);
+            cout << "Discount of " << discount << "% applied to product: " << product->name << "\n";
+        });
+
+        LogRecord logFile(logWriter, PROMOTION_LOG, LOG_OP_PROMOTION);
+        logFile << "New Promotion Created:\n";
+        logFile << "Promotion Type: Category Discount\n";
+        logFile << "Category: " << category << ", Discount: " << discount << "%\n";
+        logFile << "---------------------------------------\n";
+        logFile.close();
+        break;
+    }
+    case 3:
+    {
+        // General discount
+        float discount;
+        cout << "Enter Discount Percentage (0-100): ";
+        cin >> discount;
+        if (discount < 0 || discount > 100)
+        {
+            cout << "Invalid discount percentage. Must be between 0 and 100.\n";
+            return;
+        }
+
+        WriteGuard catalog(catalogLock);
+        forEachProduct([&](Product *product)
+        {
+            setDiscount(product, discount);
+            recordDiscountChange(product);
+            cout << "Discount of " << discount << "% applied to product: " << product->name << "\n";
+        });
+
+        LogRecord logFile(logWriter, PROMOTION_LOG, LOG_OP_PROMOTION);
+        logFile << "New Promotion Created:\n";
+        logFile << "Promotion Type: General Discount\n";
+        logFile << "Discount: " << discount << "%\n";
+        logFile << "---------------------------------------\n";
+        logFile.close();
+        break;
+    }
+    }
+
+    cout << "Promotion created successfully!\n";
+}
+
+// A single-product promotion; name receives the product's name
+ShopStatus Shopping::discountProduct(int code, float discount, string &name)
+{
+    if (!(discount >= 0 && discount <= 100))
+        return SHOP_BAD_REQUEST;
+
+    WriteGuard catalog(catalogLock);
+    Product *product = findProduct(code);
+    if (!product)
+        return SHOP_NO_PRODUCT;
+
+    setDiscount(product, discount);
+    recordDiscountChange(product);
+    name = product->name;
+
+    LogRecord logFile(logWriter, PROMOTION_LOG, LOG_OP_PROMOTION, product->code);
+    logFile << "New Promotion Created:\n";
+    logFile << "Promotion Type: Specific Product\n";
+    logFile << "Product Code: " << product->code << ", Name: " << product->name
+            << ", Discount: " << discount << "%\n";
+    logFile << "---------------------------------------\n";
+    logFile.close();
+    return SHOP_OK;
+}
+
+// -------------- VIEW ANALYTICS --------------
+// -------------- ANALYTICS SELF-CHECK --------------
+// Recomputes the dashboard with a full scan and reports any running total
+// that disagrees. Called from viewAnalytics when built with
+// -DANALYTICS_SELF_CHECK.
+void Shopping::checkAnalytics()
+{
+    int totalProducts = 0;
+    int lowStockCount = 0;
+    double totalRevenue = 0;
+    map<string, int> categoryCounts;
+    map<string, double> categoryRevenue;
+    Product *mostPopularProduct = nullptr;
+    int highestSales = 0;
+
+    forEachProduct([&](Product *product)
+    {
+        totalProducts++;
+        if (product->bookedStock < LOW_STOCK_THRESHOLD)
+            lowStockCount++;
+
+        float productRevenue = CatalogAnalytics::revenueOf(product);
+        totalRevenue += productRevenue;
+        categoryCounts[product->category]++;
+        categoryRevenue[product->category] += productRevenue;
+
+        if (product->bookedStock > highestSales)
+        {
+            highestSales = product->bookedStock;
+            mostPopularProduct = product;
+        }
+    });
+
+    auto close = [](double a, double b) { return fabs(a - b) <= 1e-4 * max(1.0, fabs(b)); };
+    int mismatches = 0;
+    auto report = [&](const string &field, double running, double recomputed)
+    {
+        cout << "Analytics check failed: " << field << " running=" << running
+             << " recomputed=" << recomputed << "\n";
+        mismatches++;
+    };
+
+    if (analytics.products() != totalProducts)
+        report("product count", analytics.products(), totalProducts);
+    if (stockIndex.lowStock() != lowStockCount)
+        report("low stock count", stockIndex.lowStock(), lowStockCount);
+    if (!close(analytics.revenue(), totalRevenue))
+        report("revenue", analytics.revenue(), totalRevenue);
+    if (stockIndex.mostStocked() != mostPopularProduct)
+        report("most popular product code", stockIndex.mostStocked() ? stockIndex.mostStocked()->code : -1,
+               mostPopularProduct ? mostPopularProduct->code : -1);
+
+    for (int id = 0; id < categoryIndex.categoryCount(); id++)
+    {
+        const string &category = categoryIndex.name(id);
+        int count = categoryCounts.count(category) ? categoryCounts[category] : 0;
+        double revenue = categoryRevenue.count(category) ? categoryRevenue[category] : 0;
+        if (analytics.categoryCount(id) != count)
+            report("count of " + category, analytics.categoryCount(id), count);
+        if (!close(analytics.categoryRevenueOf(id), revenue))
+            report("revenue of " + category, analytics.categoryRevenueOf(id), revenue);
+    }
+
+    if (mismatches == 0)
+        cout << "Analytics check passed.\n";
+}
+
+void Shopping::viewAnalytics()
+{
+    ReadGuard catalog(catalogLock);
+    unique_lock<mutex> inventory(inventoryMutex);
+    if (productIndex.empty())
+    {
+        cout << "No products available to analyze.\n";
+        return;
+    }
+
+#ifdef ANALYTICS_SELF_CHECK
+    checkAnalytics();
+#endif
+
+    // Every figure is a running total; only the category names get sorted
+    int totalProducts = analytics.products();
+    int lowStockCount = stockIndex.lowStock();
+    float totalRevenue = float(analytics.revenue());
+    Product *mostPopularProduct = stockIndex.mostStocked();
+
+    map<string, int> categoryCounts;
+    map<string, float> categoryRevenue;
+    for (int id = 0; id < categoryIndex.categoryCount(); id++)
+    {
+        if (analytics.categoryCount(id) == 0) continue;
+        categoryCounts[categoryIndex.name(id)] = analytics.categoryCount(id);
+        categoryRevenue[categoryIndex.name(id)] = float(analytics.categoryRevenueOf(id));
+    }
+    inventory.unlock();
+
+    cout << "\nAnalytics Dashboard\n";
+    cout << "========================================================\n";
+    cout << "Total Products in Inventory: " << totalProducts << "\n";
+    cout << "Total Revenue (Estimate): $" << totalRevenue << "\n";
+    cout << "Low Stock Products (Stock < " << LOW_STOCK_THRESHOLD << "): " << lowStockCount << "\n";
+    cout << "Most Popular Product: " 
+         << (mostPopularProduct ? mostPopularProduct->name : "N/A") << "\n";
+    cout << "========================================================\n";
+
+    cout << "\nCategory-wise Product Counts:\n";
+    for (auto &cat : categoryCounts)
+        cout << "Category: " << cat.first << " - Products: " << cat.second << "\n";
+
+    cout << "\nCategory-wise Revenue:\n";
+    for (auto &cat : categoryRevenue)
+        cout << "Category: " << cat.first << " - Revenue: $" << cat.second << "\n";
+
+    cout << "========================================================\n";
+
+    // Log analytics
+    LogRecord logFile(logWriter, ANALYTICS_LOG, LOG_OP_REPORT);
+    logFile << "Analytics Report:\n";
+    logFile << "Total Products: " << totalProducts << "\n";
+    logFile << "Total Revenue: $" << totalRevenue << "\n";
+    logFile << "Low Stock Products: " << lowStockCount << "\n";
+    if (mostPopularProduct)
+    {
+        logFile << "Most Popular Product: " << mostPopularProduct->name
+                << " (Stock: " << mostPopularProduct->stock << ")\n";
+    }
+    logFile << "\nCategory-wise Product Counts:\n";
+    for (auto &cat : categoryCounts)
+        logFile << "Category: " << cat.first << " - Products: " << cat.second << "\n";
+
+    logFile << "\nCategory-wise Revenue:\n";
+    for (auto &cat : categoryRevenue)
+        logFile << "Category: " << cat.first << " - Revenue: $" << cat.second << "\n";
+
+    logFile << "---------------------------------------\n";
+    logFile.close();
+}
+
+// -------------- QUERY AUDIT LOG --------------
+void Shopping::queryAuditLog()
+{
+    int log, operation, code, days;
+    cout << "Log: 1) Product 2) Promotion 3) Analytics 4) Sales Report: ";
+    cin >> log;
+    if (log < 1 || log > LOG_TARGET_COUNT)
+    {
+        cout << "Invalid log. Please select 1, 2, 3, or 4.\n";
+        return;
+    }
+
+    cout << "Operation: 0) Any 1) Add 2) Edit 3) Delete 4) Stock Event 5) Promotion 6) Report: ";
+    cin >> operation;
+    if (operation < 0 || operation >= LOG_OP_COUNT)
+    {
+        cout << "Invalid operation. Please select 0 to " << LOG_OP_COUNT - 1 << ".\n";
+        return;
+    }
+
+    cout << "Enter Product Code (-1 for any): ";
+    cin >> code;
+    cout << "Enter Number of Days to Look Back: ";
+    cin >> days;
+    if (days < 0)
+    {
+        cout << "Error: Number of days cannot be negative.\n";
+        return;
+    }
+
+    time_t now = time(nullptr);
+    time_t from = now - time_t(days) * 24 * 60 * 60;
+
+    cout << "\nAudit Log Records:\n";
+    cout << "===================================================================\n";
+    int matches = logWriter.query(LogTarget(log - 1), from, now, operation, code,
+        [](const string &record) { cout << record; });
+    cout << "===================================================================\n";
+    cout << matches << " matching record(s).\n";
+}
+
+// ========== BUYER METHODS ==========
+
+// -------------- REGISTER CUSTOMER --------------
+void Shopping::customerRegistration(Session &session)
+{
+    string username, password;
+    cout << "Enter Username: ";
+    cin >> username;
+    cout << "Enter Password: ";
+    cin >> password;
+
+    switch (signUp(session, username, password))
+    {
+    case SHOP_OK:
+        cout << "Registration successful. Welcome, " << username << "!\n";
+        break;
+    case SHOP_BAD_REQUEST:
+        cout << "Error: Username and password together must be at most "
+             << CUSTOMER_CREDENTIAL_BYTES << " characters.\n";
+        break;
+    case SHOP_USER_EXISTS:
+        cout << "User already exists. Please try logging in.\n";
+        break;
+    default:
+        cout << "Error creating customer account.\n";
+    }
+}
+
+ShopStatus Shopping::signUp(Session &session, const string &username, const string &password)
+{
+    if (username.empty() || password.empty() || !CustomerStore::fits(username, password))
+        return SHOP_BAD_REQUEST;
+
+    // Already resident, or registered in an earlier session or by another
+    // process
+    unique_lock<mutex> guard(customersMutex);
+    if (customers.find(username))
+        return SHOP_USER_EXISTS;
+
+    bool added;
+    if (!customerStore.add(username, password, added))
+        return SHOP_STORAGE_ERROR;
+    if (!added)
+        return SHOP_USER_EXISTS;
+
+    // A new customer has no wishlist to load
+    Customer *newCustomer = new Customer{username, password, 0, nullptr, true};
+    customers.insert(newCustomer);
+    guard.unlock();
+
+    // Set as current
+    switchCustomer(session, newCustomer);
+    return SHOP_OK;
+}
+
+// -------------- LOGIN CUSTOMER --------------
+void Shopping::customerLogin(Session &session)
+{
+    string username, password;
+    cout << "Enter Username: ";
+    cin >> username;
+    cout << "Enter Password: ";
+    cin >> password;
+
+    switch (signIn(session, username, password))
+    {
+    case SHOP_OK:
+        cout << "Login successful. Welcome, " << username << "!\n";
+        break;
+    case SHOP_UNAVAILABLE:
+        cout << "Error: Customer accounts are unavailable.\n";
+        break;
+    default:
+        cout << "Invalid username or password.\n";
+    }
+}
+
+ShopStatus Shopping::signIn(Session &session, const string &username, const string &password)
+{
+    // Returning customers are checked against their resident record
+    unique_lock<mutex> guard(customersMutex);
+    Customer *customer = customers.find(username);
+    if (!customer)
+    {
+        string storedPassword;
+        bool found;
+        if (!customerStore.find(username, storedPassword, found))
+            return SHOP_UNAVAILABLE;
+        if (!found)
+            return SHOP_BAD_LOGIN;
+
+        customer = new Customer{username, storedPassword, 0, nullptr, false};
+        customers.insert(customer);
+    }
+
+    if (customer->password != password)
+        return SHOP_BAD_LOGIN;
+    guard.unlock();
+    switchCustomer(session, customer);
+    return SHOP_OK;
+}
+
+// -------------- LAZY LOAD WISHLIST --------------
+void Shopping::loadWishlist(Customer *customer)
+{
+    if (customer->wishlistLoaded)
+        return;
+    customer->wishlistLoaded = true;
+
+    // Lines are "<code> <name> <price>"; names may contain spaces
+    ifstream wishlistFile(customer->username + "_wishlist.txt");
+    Product *tail = nullptr;
+    string line;
+    while (getline(wishlistFile, line))
+    {
+        size_t nameStart = line.find(' ');
+        size_t priceStart = line.rfind(' ');
+        if (nameStart == string::npos || priceStart <= nameStart)
+            continue;
+
+        Product *item = new Product{atoi(line.c_str()), line.substr(nameStart + 1, priceStart - nameStart - 1),
+                                    float(atof(line.c_str() + priceStart + 1)), 0, 0, "", nullptr, 0, 0, 0};
+        if (tail)
+            tail->left = item;
+        else
+            customer->wishlist = item;
+        tail = item;
+    }
+}
+
+// -------------- LOGOUT --------------
+// The cart is abandoned, so its units go straight back to stock instead of
+// waiting for their holds to run out
+void Shopping::customerLogout(Session &session)
+{
+    signOut(session);
+    commitChanges();
+    cout << "Logged out successfully.\n";
+}
+
+void Shopping::signOut(Session &session)
+{
+    ReadGuard catalog(catalogLock);
+    lock_guard<mutex> held(session.lock);
+    releaseCart(session);
+    session.releasedLines = 0;
+    session.customer = nullptr;
+    session.admin = false;
+}
+
+// The cart belongs to whoever filled it, so signing in as someone else on
+// the same session gives its units back first. Takes the catalog and
+// session locks, so it runs after customersMutex is released.
+void Shopping::switchCustomer(Session &session, Customer *customer)
+{
+    ReadGuard catalog(catalogLock);
+    lock_guard<mutex> held(session.lock);
+    if (session.customer && session.customer != customer)
+    {
+        releaseCart(session);
+        session.releasedLines = 0;
+    }
+    session.customer = customer;
+}
+
+// -------------- PLACE ORDER --------------
+void Shopping::placeOrder(Session &session)
+{
+    if (!session.customer)
+    {
+        cout << "Please log in to place an order.\n";
+        return;
+    }
+    reportReleasedHolds(session);
+
+    ostringstream receipt;
+    receipt << "\nFinalizing Order:\n";
+    receipt << "===================================================================\n";
+    receipt << "Code\tName\t\tPrice\tDiscount\tQuantity\tTotal\n";
+    receipt << "===================================================================\n";
+
+    uint64_t orderId;
+    float totalCost;
+    switch (checkout(session, orderId, totalCost, &receipt))
+    {
+    case SHOP_OK:
+        receipt << "===================================================================\n";
+        receipt << "Order ID: " << orderId << "\n";
+        receipt << "Total Cost: $" << totalCost << "\n";
+        receipt << "===================================================================\n";
+        cout << receipt.str();
+        break;
+    case SHOP_EMPTY_CART:
+        cout << "Your cart is empty.\n";
+        break;
+    case SHOP_UNAVAILABLE:
+        cout << "Error: Unable to save order history.\n";
+        break;
+    default:
+        cout << "Error: Unable to save the order. Your cart has not been changed.\n";
+    }
+}
+
+// Records the whole cart as one order and empties it. Receipt lines go to
+// receipt, if given.
+ShopStatus Shopping::checkout(Session &session, uint64_t &orderId, float &totalCost, ostream *receipt)
+{
+    if (!session.customer)
+        return SHOP_NOT_LOGGED_IN;
+    ReadGuard catalog(catalogLock);
+    lock_guard<mutex> held(session.lock);
+    if (session.cart.empty())
+        return SHOP_EMPTY_CART;
+
+    unique_lock<mutex> orders(ordersMutex);
+    if (!orderLedger.ready())
+        return SHOP_UNAVAILABLE;
+    orders.unlock();
+
+    // Lines in code order, so the receipt and the ledger records are too.
+    // Stock was taken when the items were added to the cart, and each line
+    // already points at its product, so nothing is looked up again here.
+    vector<const CartLine *> lines;
+    for (const CartLine &line : session.cart)
+        lines.push_back(&line);
+    sort(lines.begin(), lines.end(),
+         [](const CartLine *a, const CartLine *b) { return a->code < b->code; });
+
+    // The sold units stop being held, and the lower stock is on disk before
+    // the order is: a crash in between loses them from stock rather than
+    // putting units that were sold back on the shelf
+    auto moveHeld = [&](int sign)
+    {
+        for (const CartLine *line : lines)
+        {
+            line->product->held.give(sign * line->quantity);
+            syncStock(line->product);
+        }
+    };
+    moveHeld(-1);
+    bool journaled;
+    {
+        lock_guard<mutex> inventory(inventoryMutex);
+        journaled = journal.write();
+    }
+    if (!journaled || !journal.sync())
+    {
+        moveHeld(1);
+        return SHOP_STORAGE_ERROR;
+    }
+
+    orders.lock();
+    totalCost = 0.0f;
+    time_t placedAt = time(nullptr);
+
+    // The whole order is queued, then written to the ledger at once
+    for (const CartLine *line : lines)
+    {
+        float itemCost = line->price * line->quantity * (1 - line->discount / 100.0f);
+        totalCost += itemCost;
+
+        orderLedger.append(session.customer->username, placedAt, line->code, line->product->name,
+                           line->quantity, itemCost);
+
+        if (receipt)
+        {
+            *receipt << line->code << "\t" << line->product->name << "\t\t$" << line->price 
+                     << "\t" << line->discount << "%\t" << line->quantity 
+                     << "\t$" << itemCost << "\n";
+        }
+    }
+
+    // Nothing is recorded unless every line is; the cart (and the stock it
+    // holds) is left as it was so the order can be placed again
+    if (!orderLedger.commit(orderId))
+    {
+        orders.unlock();
+        moveHeld(1);
+        return SHOP_STORAGE_ERROR;
+    }
+    salesRollups.update();
+
+    // The held units are sold now, so their holds end without returning them
+    for (const CartLine *line : lines)
+        reservations.cancel(line->hold);
+    session.cart.clear();
+    return SHOP_OK;
+}
+
+// -------------- VIEW ORDER HISTORY --------------
+void Shopping::viewOrderHistory(Session &session)
+{
+    if (!session.customer)
+    {
+        cout << "Please log in first.\n";
+        return;
+    }
+
+    // One page at a time, newest first, straight from the ledger
+    size_t shown = 0;
+    while (true)
+    {
+        size_t pageStart = shown;
+        bool more;
+        unique_lock<mutex> orders(ordersMutex);
+        bool read = orderLedger.visitHistory(session.customer->username, shown, ORDER_HISTORY_PAGE_SIZE,
+            [&](const Order &order)
+            {
+                if (shown == 0)
+                {
+                    cout << "\nOrder History for " << session.customer->username << " (newest first):\n";
+                    cout << "===================================================================\n";
+                    cout << "Order\tDate\t\tProduct Code\tProduct Name\tQuantity\tTotal Cost\n";
+                    cout << "===================================================================\n";
+                }
+
+                char date[16];
+                struct tm local;
+                localtime_r(&order.placedAt, &local);
+                strftime(date, sizeof(date), "%Y-%m-%d", &local);
+                cout << order.orderId << "\t" << date << "\t" << order.code << "\t\t" << order.productName
+                     << "\t" << order.quantity << "\t\t$" << order.totalCost << "\n";
+                shown++;
+            }, more);
+        orders.unlock();
+
+        if (!read)
+        {
+            cout << "Error: Unable to read the order history.\n";
+            return;
+        }
+        if (shown == 0)
+        {
+            cout << "No order history found for " << session.customer->username << ".\n";
+            return;
+        }
+        if (!more || shown == pageStart)
+            break;
+
+        char choice;
+        cout << "Show older orders? (Y/N): ";
+        cin >> choice;
+        if (tolower(choice) != 'y')
+            break;
+    }
+    cout << "===================================================================\n";
+}
+
+// -------------- ADD TO WISHLIST --------------
+void Shopping::addToWishlist(Session &session, int code)
+{
+    if (!session.customer)
+    {
+        cout << "Please log in to add items to your wishlist.\n";
+        return;
+    }
+
+    ReadGuard catalog(catalogLock);
+    Product *product = findProduct(code);
+    if (!product)
+    {
+        cout << "Product not found.\n";
+        return;
+    }
+
+    // Append a copy of the product to the wishlist linked list, in file order
+    lock_guard<mutex> guard(customersMutex);
+    loadWishlist(session.customer);
+    Product *newWishlistItem = new Product{product->code, product->name, product->price, product->discount, product->stock, product->category, nullptr, 0, 0, 0};
+    Product **tail = &session.customer->wishlist;
+    while (*tail) tail = &(*tail)->left;
+    *tail = newWishlistItem;
+
+    // Also append to wishlist file
+    ofstream wishlistFile(session.customer->username + "_wishlist.txt", ios::app);
+    wishlistFile << product->code << " " << product->name << " " << product->price << "\n";
+    wishlistFile.close();
+
+    cout << "Product " << product->name << " added to wishlist.\n";
+}
+
+// -------------- VIEW WISHLIST --------------
+void Shopping::viewWishlist(Session &session)
+{
+    if (!session.customer)
+    {
+        cout << "Please log in first.\n";
+        return;
+    }
+    lock_guard<mutex> guard(customersMutex);
+    loadWishlist(session.customer);
+    if (!session.customer->wishlist)
+    {
+        cout << "Your wishlist is empty.\n";
+        return;
+    }
+
+    cout << "\nWishlist for " << session.customer->username << ":\n";
+    cout << "===================================================================\n";
+    cout << "Product Code\tProduct Name\tPrice\n";
+    cout << "===================================================================\n";
+
+    for (Product *item = session.customer->wishlist; item; item = item->left)
+        cout << item->code << "\t\t" << item->name << "\t\t$" << item->price << "\n";
+    cout << "===================================================================\n";
+}
+
+// -------------- ADD TO CART --------------
+void Shopping::addToCart(Session &session, int code, int quantity)
+{
+    reportReleasedHolds(session);
+    CartChange change;
+    switch (reserveItems(session, code, quantity, change))
+    {
+    case SHOP_OK:
+        if (change.added)
+            cout << "Added " << quantity << " units of " << change.name << " to the cart.\n";
+        else
+            cout << "Updated quantity of " << change.name << " in cart to " << change.quantity << ".\n";
+        break;
+    case SHOP_BAD_REQUEST:
+        cout << "Error: Quantity must be greater than 0.\n";
+        break;
+    case SHOP_NO_STOCK:
+        cout << "Error: Not enough stock available. Stock remaining: " << change.stockLeft << "\n";
+        break;
+    default:
+        cout << "Product not found.\n";
+    }
+}
+
+ShopStatus Shopping::reserveItems(Session &session, int code, int quantity, CartChange &change)
+{
+    if (quantity <= 0)
+        return SHOP_BAD_REQUEST;
+
+    ReadGuard catalog(catalogLock);
+    Product *product = findProduct(code);
+    if (!product)
+        return SHOP_NO_PRODUCT;
+
+    // Reduce stock from main inventory right away; fails rather than
+    // oversell if another session took the units first. The line's hold
+    // starts over, so the units stay in the cart for another full TTL.
+    lock_guard<mutex> held(session.lock);
+    if (!product->stock.take(quantity))
+    {
+        change.stockLeft = product->stock;
+        return SHOP_NO_STOCK;
+    }
+    product->held.give(quantity);
+    syncStock(product);
+
+    // If already in cart, update quantity; otherwise a new line at today's price
+    change.added = session.cart.find(code) == nullptr;
+    change.quantity = session.cart.add(product, quantity).quantity;
+    holdCartLine(session, code);
+    change.name = product->name;
+    change.stockLeft = product->stock;
+    return SHOP_OK;
+}
+
+// -------------- MODIFY CART --------------
+void Shopping::modifyCart(Session &session)
+{
+    reportReleasedHolds(session);
+    bool empty;
+    {
+        ReadGuard catalog(catalogLock);
+        lock_guard<mutex> held(session.lock);
+        empty = session.cart.empty();
+    }
+    if (empty)
+    {
+        cout << "Your cart is empty.\n";
+        return;
+    }
+
+    int code, quantity;
+    cout << "Enter Product Code to modify: ";
+    cin >> code;
+
+    bool inCart;
+    {
+        ReadGuard catalog(catalogLock);
+        lock_guard<mutex> held(session.lock);
+        inCart = session.cart.find(code) != nullptr;
+    }
+    if (!inCart)
+    {
+        cout << "Product not found in the cart.\n";
+        return;
+    }
+
+    cout << "Enter New Quantity (0 to remove): ";
+    cin >> quantity;
+
+    // The product may have been deleted, or its hold may have expired,
+    // while the quantity was typed
+    CartChange change;
+    switch (changeCartQuantity(session, code, quantity, change))
+    {
+    case SHOP_OK:
+        if (quantity == 0)
+            cout << "Removed " << change.name << " from the cart.\n";
+        else
+            cout << "Updated quantity of " << change.name << " to " << quantity << ".\n";
+        break;
+    case SHOP_BAD_REQUEST:
+        cout << "Error: Quantity cannot be negative.\n";
+        break;
+    case SHOP_NO_STOCK:
+        cout << "Error: Not enough stock available. Stock remaining: " << change.stockLeft << "\n";
+        break;
+    default:
+        cout << "Product not found in the cart.\n";
+    }
+}
+
+// A quantity of 0 removes the line
+ShopStatus Shopping::changeCartQuantity(Session &session, int code, int quantity, CartChange &change)
+{
+    if (quantity < 0)
+        return SHOP_BAD_REQUEST;
+
+    ReadGuard catalog(catalogLock);
+    lock_guard<mutex> held(session.lock);
+    const CartLine *cartItem = session.cart.find(code);
+    if (!cartItem)
+        return SHOP_NOT_IN_CART;
+
+    // Only the difference moves between the cart and the inventory
+    Product *product = cartItem->product;
+    int difference = quantity - cartItem->quantity;
+    if (difference > 0 && !product->stock.take(difference))
+    {
+        change.stockLeft = product->stock;
+        return SHOP_NO_STOCK;
+    }
+    if (difference < 0)
+        product->stock.give(-difference);
+    product->held.give(difference);
+    syncStock(product);
+
+    if (quantity == 0)
+    {
+        reservations.cancel(cartItem->hold);
+        session.cart.remove(code);
+    }
+    else
+    {
+        session.cart.setQuantity(code, quantity);
+        holdCartLine(session, code);
+    }
+    change.name = product->name;
+    change.quantity = quantity;
+    change.stockLeft = product->stock;
+    change.added = false;
+    return SHOP_OK;
+}
+
+// -------------- DISPLAY CART --------------
+void Shopping::displayCart(Session &session)
+{
+    reportReleasedHolds(session);
+    ReadGuard catalog(catalogLock);
+    lock_guard<mutex> held(session.lock);
+    if (session.cart.empty())
+    {
+        cout << "Your cart is empty.\n";
+        return;
+    }
+
+    cout << "Cart Items:\n";
+    cout << "===================================================================\n";
+    cout << "Code\tName\t\tPrice\tDiscount\tQuantity\tHeld For\n";
+    cout << "===================================================================\n";
+
+    int64_t now = ReservationWheel::clock();
+    for (const CartLine &line : session.cart)
+    {
+        int64_t minutes = (reservations.remaining(line.hold, now) + 59) / 60;
+        cout << line.code << "\t" << line.product->name << "\t\t$" << line.price 
+             << "\t" << line.discount << "%\t" << line.quantity << "\t\t" << minutes << " min\n";
+    }
+    cout << "===================================================================\n";
+    cout << "Subtotal: $" << float(session.cart.listTotal()) << "\n";
+    cout << "Discounts: -$" << float(session.cart.discounts()) << "\n";
+    cout << "Total: $" << float(session.cart.listTotal() - session.cart.discounts()) << "\n";
+    cout << "===================================================================\n";
+}
+
+// -------------- SEARCH BY NAME --------------
+void Shopping::searchProductByName(string name)
+{
+    // to lowercase
+    name = NameIndex::normalize(name);
+    bool found = false;
+    ReadGuard catalog(catalogLock);
+
+    cout << "Products matching the name '" << name << "':\n";
+    cout << "===================================================================\n";
+    cout << "Code\tName\t\tPrice\tDiscount\tStock\tCategory\n";
+    cout << "===================================================================\n";
+
+    auto printMatch = [&](const Product *product)
+    {
+        found = true;
+        cout << product->code << "\t" << product->name << "\t\t$" << product->price 
+             << "\t" << product->discount << "%\t" << product->stock 
+             << "\t" << product->category << "\n";
+    };
+
+    if (NameIndex::canSearch(name))
+    {
+        for (const Product *match : nameIndex.search(name))
+            printMatch(match);
+    }
+    else
+    {
+        // Too short for trigrams: scan, reusing one lowercase buffer across products
+        string productName;
+        visitProducts(
+            [&](const Product *product)
+            {
+                productName.assign(product->name);
+                transform(productName.begin(), productName.end(), productName.begin(), ::tolower);
+                return productName.find(name) != string::npos;
+            },
+            printMatch);
+    }
+
+    if (!found)
+        cout << "No products found matching '" << name << "'.\n";
+
+    cout << "===================================================================\n";
+}
+
+// -------------- SEARCH BY PRICE RANGE --------------
+void Shopping::searchProductByPriceRange(float minPrice, float maxPrice, bool afterDiscount)
+{
+    ReadGuard catalog(catalogLock);
+    cout << "Products in the " << (afterDiscount ? "discounted " : "") << "price range $"
+         << minPrice << " - $" << maxPrice << ":\n";
+    cout << "===================================================================\n";
+    cout << "Code\tName\t\tPrice\tDiscount\tStock\tCategory\n";
+    cout << "===================================================================\n";
+
+    inOrderTraversal(minPrice, maxPrice, afterDiscount);
+
+    cout << "===================================================================\n";
+}
+
+// ========== IN-ORDER TRAVERSALS ==========
+
+// -------------- HELPER: IN-ORDER (NO FILTER) --------------
+void Shopping::inOrderTraversal()
+{
+    forEachProduct([&](const Product *product)
+    {
+        cout << product->code << "\t" << product->name << "\t$" << product->price 
+             << "\t" << product->discount << "%\t" << product->stock 
+             << "\t" << product->category << "\n";
+    });
+}
+
+// -------------- HELPER: IN-ORDER (FILTER: category) --------------
+void Shopping::inOrderTraversal(const string &filter, const string &filterType)
+{
+    if (filterType != "category")
+        return;
+
+    forEachProductInCategory(filter, [&](const Product *product)
+    {
+        cout << product->code << "\t" << product->name << "\t$" << product->price 
+             << "\t" << product->discount << "%\t" << product->stock 
+             << "\t" << product->category << "\n";
+    });
+}
+
+// -------------- HELPER: PRICE ORDER (FILTER: price range) --------------
+void Shopping::inOrderTraversal(float minPrice, float maxPrice, bool afterDiscount)
+{
+    priceIndex.forEachInRange(minPrice, maxPrice, afterDiscount, [&](const Product *product)
+    {
+        cout << product->code << "\t" << product->name << "\t$" << product->price 
+             << "\t" << product->discount << "%\t" << product->stock 
+             << "\t" << product->category << "\n";
+    });
+}
+
+// Local midnight starting a "YYYY-MM-DD" date
+static bool parseDate(const string &text, time_t &midnight)
+{
+    struct tm local;
+    memset(&local, 0, sizeof(local));
+    char extra;
+    if (sscanf(text.c_str(), "%d-%d-%d%c", &local.tm_year, &local.tm_mon, &local.tm_mday, &extra) != 3
+        || local.tm_mon < 1 || local.tm_mon > 12 || local.tm_mday < 1 || local.tm_mday > 31)
+        return false;
+    local.tm_year -= 1900;
+    local.tm_mon -= 1;
+    local.tm_isdst = -1;
+    struct tm parsed = local;
+    midnight = mktime(&local);
+
+    // mktime moves a day that does not exist (2026-02-31) into the next month
+    return midnight != time_t(-1) && local.tm_year == parsed.tm_year && local.tm_mon == parsed.tm_mon
+           && local.tm_mday == parsed.tm_mday;
+}
+
+// -------------- GENERATE SALES REPORT --------------
+void Shopping::generateSalesReport()
+{
+    string fromText, toText;
+    time_t from = 0, to;
+    cout << "Enter Start Date (YYYY-MM-DD, 0 for the first sale): ";
+    cin >> fromText;
+    cout << "Enter End Date (YYYY-MM-DD, 0 for today): ";
+    cin >> toText;
+
+    if (fromText != "0" && !parseDate(fromText, from))
+    {
+        cout << "Error: Invalid start date.\n";
+        return;
+    }
+    if (toText == "0")
+        to = time(nullptr);
+    else if (!parseDate(toText, to))
+    {
+        cout << "Error: Invalid end date.\n";
+        return;
+    }
+
+    // The end date is inclusive: stop at the following midnight
+    struct tm local;
+    localtime_r(&to, &local);
+    local.tm_mday++;
+    local.tm_hour = local.tm_min = local.tm_sec = 0;
+    local.tm_isdst = -1;
+    to = mktime(&local);
+    if (to <= from)
+    {
+        cout << "Error: End date is before the start date.\n";
+        return;
+    }
+
+    // Map: productCode -> (totalQtySold, totalRevenue), merged from the
+    // month, day and hour rollups covering the range
+    map<int, ProductSales> salesData;
+    {
+        lock_guard<mutex> orders(ordersMutex);
+        salesData = salesRollups.report(from, to);
+    }
+    ReadGuard catalog(catalogLock);
+
+    if (salesData.empty())
+    {
+        cout << "No sales data available.\n";
+        return;
+    }
+
+    // Category subtotals, by each product's current category
+    map<string, ProductSales> categorySales;
+    for (auto &entry : salesData)
+    {
+        Product *product = findProduct(entry.first);
+        ProductSales &sales = categorySales[product ? product->category : "Unknown"];
+        sales.quantity += entry.second.quantity;
+        sales.revenue += entry.second.revenue;
+    }
+
+    char fromDate[16], toDate[16];
+    time_t last = to - 1;
+    if (from == 0)
+        strcpy(fromDate, "first sale");
+    else
+    {
+        localtime_r(&from, &local);
+        strftime(fromDate, sizeof(fromDate), "%Y-%m-%d", &local);
+    }
+    localtime_r(&last, &local);
+    strftime(toDate, sizeof(toDate), "%Y-%m-%d", &local);
+
+    cout << "\nSales Report (" << fromDate << " to " << toDate << "):\n";
+    cout << "===================================================================\n";
+    cout << "Code\tName\t\tTotal Quantity\tTotal Revenue\n";
+    cout << "===================================================================\n";
+
+    for (auto &entry : salesData)
+    {
+        int productCode = entry.first;
+        int totalQuantity = entry.second.quantity;
+        float totalRevenue = float(entry.second.revenue);
+
+        Product *product = findProduct(productCode);
+        if (product)
+        {
+            cout << product->code << "\t" << product->name << "\t\t" 
+                 << totalQuantity << "\t\t$" << totalRevenue << "\n";
+        }
+        else
+        {
+            cout << productCode << "\t" << "Unknown Product" << "\t\t" 
+                 << totalQuantity << "\t\t$" << totalRevenue << "\n";
+        }
+    }
+
+    cout << "===================================================================\n";
+    cout << "Category\tTotal Quantity\tTotal Revenue\n";
+    cout << "===================================================================\n";
+    for (auto &entry : categorySales)
+    {
+        cout << entry.first << "\t\t" << entry.second.quantity << "\t\t$" << float(entry.second.revenue) << "\n";
+    }
+    cout << "===================================================================\n";
+
+    // Save to file
+    LogRecord reportFile(logWriter, SALES_REPORT_LOG, LOG_OP_REPORT);
+    reportFile << "Sales Report (" << fromDate << " to " << toDate << "):\n";
+    reportFile << "===================================================================\n";
+    reportFile << "Code\tName\t\tTotal Quantity\tTotal Revenue\n";
+    reportFile << "===================================================================\n";
+
+    for (auto &entry : salesData)
+    {
+        int productCode = entry.first;
+        int totalQuantity = entry.second.quantity;
+        float totalRev = float(entry.second.revenue);
+
+        Product *product = findProduct(productCode);
+        if (product)
+        {
+            reportFile << product->code << "\t" << product->name << "\t\t" 
+                       << totalQuantity << "\t\t$" << totalRev << "\n";
+        }
+        else
+        {
+            reportFile << productCode << "\t" << "Unknown Product" << "\t\t"
+                       << totalQuantity << "\t\t$" << totalRev << "\n";
+        }
+    }
+
+    reportFile << "===================================================================\n";
+    reportFile << "Category\tTotal Quantity\tTotal Revenue\n";
+    reportFile << "===================================================================\n";
+    for (auto &entry : categorySales)
+    {
+        reportFile << entry.first << "\t\t" << entry.second.quantity << "\t\t$" << float(entry.second.revenue) << "\n";
+    }
+    reportFile << "===================================================================\n";
+    reportFile.close();
+}
+
+// ========== REQUESTS ==========
+// One request per line: a command word and its arguments, separated by
+// spaces, where a trailing name may contain spaces. The answer is "OK"
+// with any result fields, or "ERR <status>". Commands that list rows give
+// the row count first and follow with one tab-separated row per line, at
+// most REQUEST_ROW_LIMIT of them.
+const size_t REQUEST_ROW_LIMIT = 100;
+
+ShopStatus Shopping::execute(Session &session, const string &request, string &response, bool commit)
+{
+    istringstream in(request);
+    string command;
+    in >> command;
+    transform(command.begin(), command.end(), command.begin(), ::toupper);
+
+    ostringstream out;  // the OK line
+    ostringstream rows; // rows following it
+    size_t rowCount = 0;
+    ShopStatus status = SHOP_BAD_REQUEST;
+    string detail;        // follows the status on an ERR line
+    bool changed = false; // journaled a change, committed below
+
+    auto addRow = [&](const Product *product)
+    {
+        if (rowCount++ < REQUEST_ROW_LIMIT)
+        {
+            rows << product->code << '\t' << product->name << '\t' << product->price << '\t'
+                 << product->discount << '\t' << product->stock << '\t' << product->category << '\n';
+        }
+    };
+    auto loggedIn = [&]() { return session.customer ? SHOP_OK : SHOP_NOT_LOGGED_IN; };
+    auto admin = [&]() { return session.admin ? SHOP_OK : SHOP_NOT_ADMIN; };
+
+    if (command == "PING")
+    {
+        status = SHOP_OK;
+        out << "OK";
+    }
+    else if (command == "LOGIN" || command == "REGISTER" || command == "ADMIN")
+    {
+        string username, password;
+        if (in >> username >> password)
+        {
+            Customer *previous = session.customer;
+            if (command == "LOGIN")
+                status = signIn(session, username, password);
+            else if (command == "REGISTER")
+                status = signUp(session, username, password);
+            else if (username == ADMIN_USERNAME && password == ADMIN_PASSWORD)
+            {
+                session.admin = true;
+                status = SHOP_OK;
+            }
+            else
+            {
+                status = SHOP_BAD_LOGIN;
+            }
+            changed = previous && session.customer != previous;
+        }
+        out << "OK";
+    }
+    else if (command == "LOGOUT")
+    {
+        signOut(session);
+        changed = true;
+        status = SHOP_OK;
+        out << "OK";
+    }
+    else if (command == "PRODUCT")
+    {
+        int code;
+        if (in >> code)
+        {
+            ReadGuard catalog(catalogLock);
+            Product *product = findProduct(code);
+            status = product ? SHOP_OK : SHOP_NO_PRODUCT;
+            if (product)
+                addRow(product);
+        }
+        out << "OK " << rowCount;
+    }
+    else if (command == "LIST")
+    {
+        // Products in code order from the given code, for paging the catalog
+        int from;
+        size_t count = REQUEST_ROW_LIMIT;
+        if (in >> from)
+        {
+            if (!(in >> count))
+                count = REQUEST_ROW_LIMIT;
+            ReadGuard catalog(catalogLock);
+            for (ProductIndex::iterator it = productIndex.seek(from);
+                 it != productIndex.end() && rowCount < min(count, REQUEST_ROW_LIMIT); ++it)
+                addRow(*it);
+            status = SHOP_OK;
+        }
+        out << "OK " << rowCount;
+    }
+    else if (command == "SEARCH")
+    {
+        string name;
+        getline(in >> ws, name);
+        name = NameIndex::normalize(name);
+        if (!name.empty())
+        {
+            ReadGuard catalog(catalogLock);
+            if (NameIndex::canSearch(name))
+            {
+                for (const Product *match : nameIndex.search(name))
+                    addRow(match);
+            }
+            else
+            {
+                string productName;
+                visitProducts(
+                    [&](const Product *product)
+                    {
+                        productName.assign(product->name);
+                        transform(productName.begin(), productName.end(), productName.begin(), ::tolower);
+                        return productName.find(name) != string::npos;
+                    },
+                    addRow);
+            }
+            status = SHOP_OK;
+        }
+        out << "OK " << min(rowCount, REQUEST_ROW_LIMIT);
+    }
+    else if (command == "PRICE")
+    {
+        // Cheapest first, on the price after discount
+        float minPrice, maxPrice;
+        if (in >> minPrice >> maxPrice)
+        {
+            ReadGuard catalog(catalogLock);
+            priceIndex.forEachInRange(minPrice, maxPrice, true, addRow);
+            status = SHOP_OK;
+        }
+        out << "OK " << min(rowCount, REQUEST_ROW_LIMIT);
+    }
+    else if (command == "ADD" || command == "SET")
+    {
+        int code, quantity;
+        if (!(in >> code >> quantity))
+            status = SHOP_BAD_REQUEST;
+        else if ((status = loggedIn()) == SHOP_OK)
+        {
+            CartChange change;
+            if (command == "ADD")
+                status = reserveItems(session, code, quantity, change);
+            else
+                status = changeCartQuantity(session, code, quantity, change);
+            if (status == SHOP_NO_STOCK)
+                detail = to_string(change.stockLeft);
+            out << "OK " << change.quantity << " " << change.stockLeft;
+            changed = true;
+        }
+    }
+    else if (command == "CART")
+    {
+        if ((status = loggedIn()) == SHOP_OK)
+        {
+            ReadGuard catalog(catalogLock);
+            lock_guard<mutex> held(session.lock);
+            int64_t now = ReservationWheel::clock();
+            for (const CartLine &line : session.cart)
+            {
+                rows << line.code << '\t' << line.product->name << '\t' << line.price << '\t' << line.discount
+                     << '\t' << line.quantity << '\t' << reservations.remaining(line.hold, now) << '\n';
+                rowCount++;
+            }
+            out << "OK " << rowCount << " " << float(session.cart.listTotal()) << " "
+                << float(session.cart.discounts());
+        }
+    }
+    else if (command == "ORDER")
+    {
+        uint64_t orderId;
+        float totalCost;
+        status = checkout(session, orderId, totalCost, nullptr);
+        out << "OK " << orderId << " " << totalCost;
+    }
+    else if (command == "HISTORY")
+    {
+        // Newest first, one page of ORDER_HISTORY_PAGE_SIZE lines
+        size_t page = 0;
+        in >> page;
+        if ((status = loggedIn()) == SHOP_OK)
+        {
+            lock_guard<mutex> orders(ordersMutex);
+            bool more;
+            if (!orderLedger.ready())
+                status = SHOP_UNAVAILABLE;
+            else if (!orderLedger.visitHistory(session.customer->username, page * ORDER_HISTORY_PAGE_SIZE,
+                                               ORDER_HISTORY_PAGE_SIZE, [&](const Order &order)
+                     {
+                         rows << order.orderId << '\t' << order.placedAt << '\t' << order.code << '\t'
+                              << order.productName << '\t' << order.quantity << '\t' << order.totalCost << '\n';
+                         rowCount++;
+                     }, more))
+                status = SHOP_STORAGE_ERROR;
+            else
+                out << "OK " << rowCount << " " << (more ? 1 : 0);
+        }
+    }
+    else if (command == "NEW")
+    {
+        // NEW <code> <price> <discount> <stock> <category> <name>
+        Product details;
+        if ((status = admin()) == SHOP_OK)
+        {
+            if (in >> details.code >> details.price >> details.discount >> details.stock >> details.category
+                && getline(in >> ws, details.name))
+                status = createProduct(details);
+            else
+                status = SHOP_BAD_REQUEST;
+            changed = true;
+        }
+        out << "OK";
+    }
+    else if (command == "EDIT")
+    {
+        // EDIT <code> <price> <discount> <stock> [<category> [<name>]];
+        // -1 keeps a number and "-" keeps the category
+        int code, stock;
+        float price, discount;
+        string category, name;
+        if ((status = admin()) == SHOP_OK)
+        {
+            if (in >> code >> price >> discount >> stock)
+            {
+                if (in >> category)
+                    getline(in >> ws, name);
+                if (category == "-")
+                    category.clear();
+                Product updated;
+                status = updateProduct(code, name, price, discount, stock, category, updated);
+                changed = true;
+            }
+            else
+            {
+                status = SHOP_BAD_REQUEST;
+            }
+        }
+        out << "OK";
+    }
+    else if (command == "DISCOUNT")
+    {
+        int code;
+        float discount;
+        string name;
+        if ((status = admin()) == SHOP_OK)
+        {
+            status = (in >> code >> discount) ? discountProduct(code, discount, name) : SHOP_BAD_REQUEST;
+            changed = true;
+        }
+        out << "OK";
+    }
+    else if (command == "DELETE")
+    {
+        int code;
+        if ((status = admin()) == SHOP_OK)
+        {
+            status = (in >> code) ? removeProduct(code) : SHOP_BAD_REQUEST;
+            changed = true;
+        }
+        out << "OK";
+    }
+    else if (command == "LOWSTOCK")
+    {
+        // Lowest stock first
+        int threshold;
+        if ((status = admin()) == SHOP_OK)
+        {
+            if (in >> threshold)
+            {
+                ReadGuard catalog(catalogLock);
+                lock_guard<mutex> inventory(inventoryMutex);
+                stockIndex.forEachBelow(threshold, addRow);
+            }
+            else
+            {
+                status = SHOP_BAD_REQUEST;
+            }
+        }
+        out << "OK " << min(rowCount, REQUEST_ROW_LIMIT);
+    }
+    else if (command == "STATS")
+    {
+        if ((status = admin()) == SHOP_OK)
+        {
+            ReadGuard catalog(catalogLock);
+            lock_guard<mutex> inventory(inventoryMutex);
+            char revenue[32];
+            snprintf(revenue, sizeof(revenue), "%.2f", analytics.revenue());
+            out << "OK " << analytics.products() << " " << revenue << " " << stockIndex.lowStock();
+        }
+    }
+
+    // Persist whatever this request changed as one journal group
+    if (changed && commit && !commitChanges())
+        status = SHOP_STORAGE_ERROR;
+
+    if (status == SHOP_OK)
+        response = out.str() + "\n" + rows.str();
+    else
+        response = string("ERR ") + statusName(status) + (detail.empty() ? "" : " " + detail) + "\n";
+    return status;
+}
+
+// ========== MAIN MENUS ==========
+
+// -------------- MAIN MENU --------------
+void Shopping::menu()
+{
+    int choice;
+    do
+    {
+        cout << "\n\t\tWelcome to the Supermarket System\n";
+        cout << "=====================================\n";
+        cout << "1) Administrator\n";
+        cout << "2) Buyer\n";
+        cout << "3) Exit\n";
+        cout << "=====================================\n";
+        cout << "Enter your choice: ";
+        cin >> choice;
+
+        switch (choice)
+        {
+        case 1:
+        {
+            // Force admin to login first
+            bool loggedIn = adminLogin();
+            if (loggedIn)
+            {
+                administrator();
+            }
+            break;
+        }
+        case 2:
+            buyer();
+            break;
+        case 3:
+            cout << "Exiting...\n";
+            break;
+        default:
+            cout << "Invalid choice. Please try again.\n";
+        }
+    } while (choice != 3);
+}
+
+// -------------- ADMINISTRATOR MENU --------------
+void Shopping::administrator()
+{
+    int choice;
+    do
+    {
+        cout << "\nAdministrator Menu\n";
+        cout << "=========================\n";
+        cout << "1) Add Product\n";
+        cout << "2) Edit Product\n";
+        cout << "3) Delete Product\n";
+        cout << "4) List Products\n";
+        cout << "5) List Products by Category\n";
+        cout << "6) Search Products by Name\n";
         cout << "7) Search Products by Price Range\n";
         cout << "8) Generate Sales Report\n";
         cout << "9) Low Stock Alerts\n";
         cout << "10) Sort Products by Field\n";
         cout << "11) Create Promotions\n";
         cout << "12) View Analytics\n";
-        cout << "13) Back to Main Menu\n";
+        cout << "13) Query Audit Log\n";
+        cout << "14) Back to Main Menu\n";
+        cout << "=========================\n";
+        cout << "Enter your choice: ";
+        cin >> choice;
+
+        switch (choice)
+        {
+        case 1:
+            addProduct();
+            break;
+        case 2:
+            editProduct();
+            break;
+        case 3:
+            deleteProduct();
+            break;
+        case 4:
+            listProducts();
+            break;
+        case 5:
+            listProductsByCategory();
+            break;
+        case 6:
+        {
+            string name;
+            cout << "Enter Product Name: ";
+            cin >> name;
+            searchProductByName(name);
+            break;
+        }
+        case 7:
+        {
+            float minPrice, maxPrice;
+            cout << "Enter Min Price: ";
+            cin >> minPrice;
+            cout << "Enter Max Price: ";
+            cin >> maxPrice;
+            int priceType;
+            cout << "Match Against 1) List Price 2) Price After Discount: ";
+            cin >> priceType;
+            searchProductByPriceRange(minPrice, maxPrice, priceType == 2);
+            break;
+        }
+        case 8:
+            generateSalesReport();
+            break;
+        case 9:
+            lowStockAlert();
+            break;
+        case 10:
+        {
+            int field;
+            cout << "Sort by: 1) Name 2) Price 3) Stock\n";
+            cin >> field;
+            sortProductsByField(field);
+            break;
+        }
+        case 11:
+            createPromotion();
+            break;
+        case 12:
+            viewAnalytics();
+            break;
+        case 13:
+            queryAuditLog();
+            break;
+        case 14:
+            return; // back to main menu
+        default:
+            cout << "Invalid choice. Please try again.\n";
+        }
+
+        // Persist whatever this action changed as one journal group
+        commitChanges();
+    } while (true);
+}
+
+// -------------- BUYER MENU --------------
+void Shopping::buyer()
+{
+    int choice;
+    do
+    {
+        cout << "\nBuyer Menu\n";
+        cout << "=========================\n";
+        cout << "1) Login\n";
+        cout << "2) Register\n";
+        cout << "3) Add to Cart\n";
+        cout << "4) Modify Cart\n";
+        cout << "5) Display Cart\n";
+        cout << "6) Place Order\n";
+        cout << "7) View Order History\n";
+        cout << "8) Add to Wishlist\n";
+        cout << "9) View Wishlist\n";
+        cout << "10) Logout\n";
+        cout << "11) Back to Main Menu\n";
         cout << "=========================\n";
         cout << "Enter your choice: ";
         cin >> choice;
 
-        switch (choice)
+        switch (choice)
+        {
+        case 1:
+            customerLogin(console);
+            break;
+        case 2:
+            customerRegistration(console);
+            break;
+        case 3:
+        {
+            if (!console.customer)
+            {
+                cout << "Please log in to add items to your cart.\n";
+                break;
+            }
+            int code, quantity;
+            cout << "Enter Product Code: ";
+            cin >> code;
+            cout << "Enter Quantity: ";
+            cin >> quantity;
+            addToCart(console, code, quantity);
+            break;
+        }
+        case 4:
+        {
+            if (!console.customer)
+            {
+                cout << "Please log in to modify your cart.\n";
+                break;
+            }
+            modifyCart(console);
+            break;
+        }
+        case 5:
+        {
+            if (!console.customer)
+            {
+                cout << "Please log in to display your cart.\n";
+                break;
+            }
+            displayCart(console);
+            break;
+        }
+        case 6:
+        {
+            if (!console.customer)
+            {
+                cout << "Please log in to place an order.\n";
+                break;
+            }
+            placeOrder(console);
+            break;
+        }
+        case 7:
+        {
+            if (!console.customer)
+            {
+                cout << "Please log in to view your order history.\n";
+                break;
+            }
+            viewOrderHistory(console);
+            break;
+        }
+        case 8:
+        {
+            if (!console.customer)
+            {
+                cout << "Please log in to add items to wishlist.\n";
+                break;
+            }
+            int code;
+            cout << "Enter Product Code to Add to Wishlist: ";
+            cin >> code;
+            addToWishlist(console, code);
+            break;
+        }
+        case 9:
+        {
+            if (!console.customer)
+            {
+                cout << "Please log in first.\n";
+                break;
+            }
+            viewWishlist(console);
+            break;
+        }
+        case 10:
+            customerLogout(console);
+            return;
+        case 11:
+            return; // back to main menu
+        default:
+            cout << "Invalid choice. Please try again.\n";
+        }
+
+        // Persist whatever this action changed as one journal group
+        commitChanges();
+    } while (true);
+}
+
+// ======================================
+// Socket Server
+// ======================================
+// Serves the request protocol (see Shopping::execute) on a localhost TCP
+// port or a Unix-domain socket. One thread runs an epoll loop: it accepts
+// connections, splits what they send into request lines and sends any
+// answers a worker could not send straight away. A pool of workers runs
+// the requests. Each connection is a Session whose requests run in order
+// on one worker at a time, so clients may pipeline them; the worker runs
+// everything queued for the connection, then sends the answers with one
+// send. A client that quits, or closes its end, gets answers to what it
+// already sent before the connection is closed and its cart released.
+// A client that sends requests faster than it reads the answers is not
+// read again, and its queued requests wait, until the answers drain.
+const size_t SERVER_MAX_LINE = 64 * 1024;
+const size_t SERVER_READ_CHUNK = 64 * 1024;   // per connection per wakeup
+const size_t SERVER_MAX_QUEUED = 4096;        // requests read but not run
+const size_t SERVER_MAX_OUTPUT = 1024 * 1024; // answers not sent yet
+const int SERVER_MAX_EVENTS = 256;
+
+// "7070" or "host:7070" is a TCP address (the host defaults to
+// 127.0.0.1); anything else is the path of a Unix-domain socket
+bool parseSocketAddress(const string &address, sockaddr_storage &storage, socklen_t &length)
+{
+    memset(&storage, 0, sizeof(storage));
+    size_t colon = address.rfind(':');
+    string port = colon == string::npos ? address : address.substr(colon + 1);
+    if (!port.empty() && port.find_first_not_of("0123456789") == string::npos && address.find('/') == string::npos)
+    {
+        sockaddr_in *inet = reinterpret_cast<sockaddr_in *>(&storage);
+        inet->sin_family = AF_INET;
+        inet->sin_port = htons(uint16_t(atoi(port.c_str())));
+        string host = colon == string::npos ? "127.0.0.1" : address.substr(0, colon);
+        length = sizeof(sockaddr_in);
+        return inet_pton(AF_INET, host.c_str(), &inet->sin_addr) == 1;
+    }
+
+    sockaddr_un *local = reinterpret_cast<sockaddr_un *>(&storage);
+    if (address.empty() || address.size() >= sizeof(local->sun_path))
+        return false;
+    local->sun_family = AF_UNIX;
+    memcpy(local->sun_path, address.c_str(), address.size() + 1);
+    length = sizeof(sockaddr_un);
+    return true;
+}
+
+// Thousands of clients need more descriptors than the usual soft limit
+void raiseDescriptorLimit()
+{
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+    {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+struct ServerConnection
+{
+    int fd;
+    Session session;
+    string input;           // event loop only: bytes after the last full line
+    mutex lock;             // the fields below
+    deque<string> requests; // full lines waiting for a worker
+    string output;          // answers not sent yet
+    bool scheduled;         // queued for, or being served by, a worker
+    uint32_t events;        // what epoll watches for
+    bool quitting;          // QUIT or end of input: close once answered
+    bool hungUp;            // the loop has let go; the worker closes it
+
+    explicit ServerConnection(int socket)
+        : fd(socket), scheduled(false), events(EPOLLIN), quitting(false), hungUp(false) {}
+};
+
+class ShopServer
+{
+private:
+    Shopping &shop;
+    int epollFd;
+    int listenFd;
+    int signalFd;
+    string socketPath; // removed again on shutdown
+    unordered_map<int, ServerConnection *> connections; // event loop only
+
+    vector<thread> workers;
+    mutex queueLock;
+    condition_variable queued;
+    deque<ServerConnection *> queue;
+    bool stopping;
+
+    // With connection->lock held
+    void schedule(ServerConnection *connection)
+    {
+        connection->scheduled = true;
+        lock_guard<mutex> guard(queueLock);
+        queue.push_back(connection);
+        queued.notify_one();
+    }
+
+    // Reads while the connection is open and neither its queue nor its
+    // answers are over the limit; waits to send while answers are pending.
+    // With connection->lock held.
+    void watch(ServerConnection *connection)
+    {
+        bool input = !connection->quitting && connection->requests.size() < SERVER_MAX_QUEUED
+                     && connection->output.size() < SERVER_MAX_OUTPUT;
+        bool output = !connection->output.empty();
+        uint32_t events = (input ? uint32_t(EPOLLIN) : 0u) | (output ? uint32_t(EPOLLOUT) : 0u);
+        if (connection->hungUp || events == connection->events)
+            return;
+        epoll_event event;
+        event.events = events;
+        event.data.fd = connection->fd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, connection->fd, &event);
+        connection->events = events;
+    }
+
+    // Sends what the socket takes now; the loop sends the rest once it
+    // drains. A quitting connection is shut down after its last answer,
+    // which the loop sees as a hang-up. With connection->lock held.
+    void flush(ServerConnection *connection)
+    {
+        size_t sent = 0;
+        while (sent < connection->output.size())
+        {
+            ssize_t written = send(connection->fd, connection->output.data() + sent,
+                                   connection->output.size() - sent, MSG_NOSIGNAL);
+            if (written > 0)
+                sent += size_t(written);
+            else if (written < 0 && errno == EINTR)
+                continue;
+            else if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            else
+            {
+                // The client is gone; the loop will see the hang-up
+                sent = connection->output.size();
+                break;
+            }
+        }
+        connection->output.erase(0, sent);
+        watch(connection);
+
+        if (connection->quitting && connection->output.empty() && connection->requests.empty())
+            shutdown(connection->fd, SHUT_RDWR);
+    }
+
+    // Runs everything the connection has queued, then sends the answers.
+    // Stops early while the client leaves too many answers unread; the
+    // loop schedules the connection again once they drain.
+    void serve(ServerConnection *connection)
+    {
+        unique_lock<mutex> guard(connection->lock);
+        do
+        {
+            while (!connection->hungUp && !connection->requests.empty()
+                   && connection->output.size() < SERVER_MAX_OUTPUT)
+            {
+                string request = move(connection->requests.front());
+                connection->requests.pop_front();
+                guard.unlock();
+
+                string command, response;
+                istringstream(request) >> command;
+                transform(command.begin(), command.end(), command.begin(), ::toupper);
+                bool quit = command == "QUIT";
+                if (quit)
+                    response = "OK\n";
+                else
+                    shop.execute(connection->session, request, response);
+
+                guard.lock();
+                connection->output += response;
+                if (quit)
+                {
+                    connection->quitting = true;
+                    connection->requests.clear();
+                }
+            }
+
+            if (connection->hungUp)
+            {
+                guard.unlock();
+                finish(connection);
+                return;
+            }
+            flush(connection);
+        } while (!connection->requests.empty() && connection->output.size() < SERVER_MAX_OUTPUT);
+        connection->scheduled = false;
+    }
+
+    // The last owner of a connection releases its cart and closes it
+    void finish(ServerConnection *connection)
+    {
+        shop.closeSession(connection->session);
+        close(connection->fd);
+        delete connection;
+    }
+
+    void runWorker()
+    {
+        while (true)
+        {
+            ServerConnection *connection;
+            {
+                unique_lock<mutex> guard(queueLock);
+                queued.wait(guard, [&] { return stopping || !queue.empty(); });
+                if (queue.empty())
+                    return;
+                connection = queue.front();
+                queue.pop_front();
+            }
+            serve(connection);
+        }
+    }
+
+    void acceptClients()
+    {
+        while (true)
+        {
+            int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return;
+            }
+
+            // Fails harmlessly on Unix-domain sockets
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+            ServerConnection *connection = new ServerConnection(fd);
+            shop.openSession(connection->session);
+            epoll_event event;
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+            connections[fd] = connection;
+        }
+    }
+
+    void readRequests(ServerConnection *connection)
+    {
+        char buffer[16384];
+        size_t received = 0;
+        bool ended = false, failed = false;
+        while (received < SERVER_READ_CHUNK)
+        {
+            ssize_t count = recv(connection->fd, buffer, sizeof(buffer), 0);
+            if (count > 0)
+            {
+                connection->input.append(buffer, size_t(count));
+                received += size_t(count);
+            }
+            else if (count == 0)
+            {
+                ended = true;
+                break;
+            }
+            else if (errno == EINTR)
+            {
+                continue;
+            }
+            else
+            {
+                failed = errno != EAGAIN && errno != EWOULDBLOCK;
+                break;
+            }
+        }
+
+        vector<string> lines;
+        size_t start = 0, newline;
+        while ((newline = connection->input.find('\n', start)) != string::npos)
+        {
+            size_t end = newline;
+            if (end > start && connection->input[end - 1] == '\r')
+                end--;
+            if (end > start)
+                lines.push_back(connection->input.substr(start, end - start));
+            start = newline + 1;
+        }
+        connection->input.erase(0, start);
+        if (connection->input.size() > SERVER_MAX_LINE)
+            failed = true;
+
+        if (failed)
+        {
+            hangUp(connection);
+            return;
+        }
+
+        lock_guard<mutex> guard(connection->lock);
+        if (connection->quitting)
+            return;
+        for (string &line : lines)
+            connection->requests.push_back(move(line));
+        watch(connection);
+
+        if (ended)
+        {
+            // Answer what was sent, then close
+            connection->quitting = true;
+            watch(connection);
+            if (!connection->scheduled && connection->requests.empty())
+                flush(connection);
+        }
+        if (!connection->scheduled && !connection->requests.empty())
+            schedule(connection);
+    }
+
+    // The loop lets go of the connection and a worker finishes it off
+    void hangUp(ServerConnection *connection)
+    {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, connection->fd, nullptr);
+        connections.erase(connection->fd);
+        lock_guard<mutex> guard(connection->lock);
+        connection->hungUp = true;
+        if (!connection->scheduled)
+            schedule(connection);
+    }
+
+public:
+    explicit ShopServer(Shopping &shopping)
+        : shop(shopping), epollFd(-1), listenFd(-1), signalFd(-1), stopping(false) {}
+
+    ~ShopServer()
+    {
+        if (listenFd >= 0) close(listenFd);
+        if (signalFd >= 0) close(signalFd);
+        if (epollFd >= 0) close(epollFd);
+        if (!socketPath.empty()) unlink(socketPath.c_str());
+    }
+
+    // SIGINT and SIGTERM stop the server through a signalfd. They must be
+    // blocked before any thread starts so every thread inherits the mask.
+    static void blockStopSignals()
+    {
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    }
+
+    bool start(const string &address, size_t workerCount)
+    {
+        sockaddr_storage storage;
+        socklen_t length;
+        if (!parseSocketAddress(address, storage, length))
+        {
+            cout << "Error: Invalid server address " << address << ".\n";
+            return false;
+        }
+
+        raiseDescriptorLimit();
+        listenFd = socket(storage.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (storage.ss_family == AF_UNIX)
+        {
+            unlink(address.c_str());
+            socketPath = address;
+        }
+        int one = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (listenFd < 0 || ::bind(listenFd, reinterpret_cast<sockaddr *>(&storage), length) != 0
+            || listen(listenFd, SOMAXCONN) != 0)
+        {
+            cout << "Error: Unable to listen on " << address << ": " << strerror(errno) << ".\n";
+            return false;
+        }
+
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        signalFd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        epoll_event event;
+        event.events = EPOLLIN;
+        event.data.fd = listenFd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+        event.data.fd = signalFd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, signalFd, &event);
+
+        for (size_t i = 0; i < max<size_t>(workerCount, 1); i++)
+            workers.push_back(thread(&ShopServer::runWorker, this));
+
+        cout << "Serving on " << address << " with " << workers.size()
+             << " workers. Press Ctrl+C to stop.\n";
+        cout.flush();
+        return true;
+    }
+
+    // Runs until SIGINT or SIGTERM, then closes every connection
+    void run()
+    {
+        epoll_event events[SERVER_MAX_EVENTS];
+        bool running = true;
+        while (running)
+        {
+            int count = epoll_wait(epollFd, events, SERVER_MAX_EVENTS, -1);
+            for (int i = 0; i < count; i++)
+            {
+                int fd = events[i].data.fd;
+                if (fd == listenFd)
+                {
+                    acceptClients();
+                    continue;
+                }
+                if (fd == signalFd)
+                {
+                    running = false;
+                    continue;
+                }
+
+                // Events for a connection hung up earlier in this batch are stale
+                unordered_map<int, ServerConnection *>::iterator found = connections.find(fd);
+                if (found == connections.end())
+                    continue;
+                ServerConnection *connection = found->second;
+
+                if (events[i].events & EPOLLIN)
+                    readRequests(connection);
+                if (!connections.count(fd))
+                    continue;
+                if (events[i].events & (EPOLLHUP | EPOLLERR))
+                {
+                    hangUp(connection);
+                    continue;
+                }
+                if (events[i].events & EPOLLOUT)
+                {
+                    lock_guard<mutex> guard(connection->lock);
+                    flush(connection);
+                    // Requests held back behind unread answers can run now
+                    if (!connection->scheduled && !connection->requests.empty()
+                        && connection->output.size() < SERVER_MAX_OUTPUT)
+                        schedule(connection);
+                }
+            }
+        }
+
+        vector<ServerConnection *> open;
+        for (auto &entry : connections)
+            open.push_back(entry.second);
+        for (ServerConnection *connection : open)
+            hangUp(connection);
+
+        {
+            lock_guard<mutex> guard(queueLock);
+            stopping = true;
+            queued.notify_all();
+        }
+        for (thread &worker : workers)
+            worker.join();
+        cout << "Server stopped.\n";
+    }
+};
+
+// ======================================
+// Load Generator
+// ======================================
+// Drives a server with many concurrent clients, each of which logs in and
+// then sends requests one at a time: mostly product lookups, with cart
+// changes, cart views, listings and checkouts mixed in. Clients are spread
+// over a few threads, each with its own epoll loop. At the end it reports
+// throughput and the latency distribution. Refusals such as running out of
+// stock are part of normal traffic and are counted apart from errors.
+struct LoadClient
+{
+    int fd;
+    int id;
+    mt19937 random;
+    int remaining;     // requests still to send
+    bool loggingIn;    // the first exchange, not measured
+    string command;    // of the request in flight
+    int rowsLeft;      // rows still to come for it; -1 until its status line
+    string input;
+    chrono::steady_clock::time_point sentAt;
+};
+
+struct LoadResults
+{
+    vector<uint32_t> latencies; // microseconds
+    size_t ok, refused, errors;
+    bool timedOut;
+
+    LoadResults() : ok(0), refused(0), errors(0), timedOut(false) {}
+};
+
+int connectTo(const sockaddr_storage &storage, socklen_t length)
+{
+    int fd = socket(storage.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+    if (connect(fd, reinterpret_cast<const sockaddr *>(&storage), length) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+bool sendLine(int fd, const string &line)
+{
+    string data = line + "\n";
+    return writeAll(fd, data.data(), data.size());
+}
+
+class LoadGenerator
+{
+private:
+    sockaddr_storage address;
+    socklen_t addressLength;
+    vector<int> codes;
+
+    static bool listsRows(const string &command)
+    {
+        return command == "PRODUCT" || command == "LIST" || command == "CART";
+    }
+
+    string nextRequest(LoadClient &client)
+    {
+        int code = codes[client.random() % codes.size()];
+        int pick = int(client.random() % 100);
+        if (pick < 50) return "PRODUCT " + to_string(code);
+        if (pick < 70) return "ADD " + to_string(code) + " 1";
+        if (pick < 80) return "CART";
+        if (pick < 90) return "SET " + to_string(code) + " 0";
+        if (pick < 95) return "LIST " + to_string(code) + " 10";
+        return "ORDER";
+    }
+
+    bool send(LoadClient &client, const string &request)
+    {
+        client.command = request.substr(0, request.find(' '));
+        client.rowsLeft = -1;
+        client.sentAt = chrono::steady_clock::now();
+        return sendLine(client.fd, request);
+    }
+
+    // Consumes complete lines; returns true once the whole answer is in
+    bool answered(LoadClient &client, LoadResults &results)
+    {
+        size_t newline;
+        while ((newline = client.input.find('\n')) != string::npos)
+        {
+            string line = client.input.substr(0, newline);
+            client.input.erase(0, newline + 1);
+            if (client.rowsLeft < 0)
+            {
+                bool ok = line.compare(0, 2, "OK") == 0;
+                client.rowsLeft = ok && listsRows(client.command) ? atoi(line.c_str() + 3) : 0;
+                if (client.loggingIn)
+                {
+                    if (!ok && client.command == "LOGIN")
+                    {
+                        send(client, "REGISTER load" + to_string(client.id) + " pw");
+                        continue;
+                    }
+                    if (!ok)
+                        results.errors++;
+                }
+                else if (ok)
+                    results.ok++;
+                else if (line.find("no-stock") != string::npos || line.find("not-in-cart") != string::npos
+                         || line.find("empty-cart") != string::npos || line.find("no-product") != string::npos)
+                    results.refused++;
+                else
+                    results.errors++;
+            }
+            else
+            {
+                client.rowsLeft--;
+            }
+            if (client.rowsLeft == 0)
+                return true;
+        }
+        return false;
+    }
+
+    void runClients(vector<LoadClient> &clients, LoadResults &results)
+    {
+        int epollFd = epoll_create1(EPOLL_CLOEXEC);
+        size_t active = 0;
+        for (size_t i = 0; i < clients.size(); i++)
+        {
+            LoadClient &client = clients[i];
+            if (client.fd < 0)
+                continue;
+            epoll_event event;
+            event.events = EPOLLIN;
+            event.data.u64 = i;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, client.fd, &event);
+            client.loggingIn = true;
+            send(client, "LOGIN load" + to_string(client.id) + " pw");
+            active++;
+        }
+
+        epoll_event events[SERVER_MAX_EVENTS];
+        char buffer[16384];
+        while (active > 0)
         {
-        case 1:
-            addProduct();
-            break;
-        case 2:
-            editProduct();
-            break;
-        case 3:
-            deleteProduct();
-            break;
-        case 4:
-            listProducts();
-            break;
-        case 5:
-            listProductsByCategory();
-            break;
-        case 6:
+            int count = epoll_wait(epollFd, events, SERVER_MAX_EVENTS, 10000);
+            if (count <= 0)
+            {
+                results.timedOut = true;
+                break;
+            }
+            for (int i = 0; i < count; i++)
+            {
+                LoadClient &client = clients[events[i].data.u64];
+                ssize_t received = recv(client.fd, buffer, sizeof(buffer), 0);
+                if (received <= 0)
+                {
+                    results.errors++;
+                    epoll_ctl(epollFd, EPOLL_CTL_DEL, client.fd, nullptr);
+                    active--;
+                    continue;
+                }
+                client.input.append(buffer, size_t(received));
+                if (!answered(client, results))
+                    continue;
+
+                if (!client.loggingIn)
+                {
+                    results.latencies.push_back(uint32_t(chrono::duration_cast<chrono::microseconds>(
+                        chrono::steady_clock::now() - client.sentAt).count()));
+                    client.remaining--;
+                }
+                client.loggingIn = false;
+
+                if (client.remaining > 0 && send(client, nextRequest(client)))
+                    continue;
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, client.fd, nullptr);
+                active--;
+            }
+        }
+        close(epollFd);
+    }
+
+public:
+    LoadGenerator() : addressLength(0) {}
+
+    int run(const string &target, int clientCount, int requestsPerClient)
+    {
+        if (!parseSocketAddress(target, address, addressLength))
         {
-            string name;
-            cout << "Enter Product Name: ";
-            cin >> name;
-            searchProductByName(name);
-            break;
+            cout << "Error: Invalid server address " << target << ".\n";
+            return 1;
         }
-        case 7:
+        raiseDescriptorLimit();
+
+        // Product codes to ask for come from the start of the catalog
+        int control = connectTo(address, addressLength);
+        if (control < 0 || !sendLine(control, "LIST 0 100"))
         {
-            float minPrice, maxPrice;
-            cout << "Enter Min Price: ";
-            cin >> minPrice;
-            cout << "Enter Max Price: ";
-            cin >> maxPrice;
-            searchProductByPriceRange(minPrice, maxPrice);
-            break;
+            cout << "Error: Unable to connect to " << target << ".\n";
+            return 1;
         }
-        case 8:
-            generateSalesReport();
-            break;
-        case 9:
-            lowStockAlert();
-            break;
-        case 10:
+        FILE *answers = fdopen(control, "r");
+        char line[4096];
+        int rows = 0;
+        if (fgets(line, sizeof(line), answers) && strncmp(line, "OK ", 3) == 0)
+            rows = atoi(line + 3);
+        for (int i = 0; i < rows && fgets(line, sizeof(line), answers); i++)
+            codes.push_back(atoi(line));
+        fclose(answers);
+        if (codes.empty())
         {
-            int field;
-            cout << "Sort by: 1) Name 2) Price 3) Stock\n";
-            cin >> field;
-            sortProductsByField(field);
-            break;
+            cout << "Error: The server has no products to request.\n";
+            return 1;
         }
-        case 11:
-            createPromotion();
-            break;
-        case 12:
-            viewAnalytics();
-            break;
-        case 13:
-            return; // back to main menu
-        default:
-            cout << "Invalid choice. Please try again.\n";
+
+        size_t threadCount = max<size_t>(1, min<size_t>(thread::hardware_concurrency() / 2, 8));
+        threadCount = min(threadCount, size_t(max(clientCount, 1)));
+        vector<vector<LoadClient> > groups(threadCount);
+        int connected = 0;
+        for (int id = 0; id < clientCount; id++)
+        {
+            LoadClient client;
+            client.fd = connectTo(address, addressLength);
+            client.id = id;
+            client.random.seed(uint32_t(id) * 2654435761u + 1);
+            client.remaining = requestsPerClient;
+            client.loggingIn = true;
+            client.rowsLeft = -1;
+            if (client.fd >= 0)
+                connected++;
+            groups[id % threadCount].push_back(client);
         }
-    } while (true);
-}
+        if (connected < clientCount)
+            cout << "Warning: Only " << connected << " of " << clientCount << " clients connected.\n";
+
+        cout << "Load test: " << connected << " clients x " << requestsPerClient << " requests against "
+             << target << "\n";
+        vector<LoadResults> results(threadCount);
+        vector<thread> threads;
+        chrono::steady_clock::time_point started = chrono::steady_clock::now();
+        for (size_t t = 0; t < threadCount; t++)
+            threads.push_back(thread(&LoadGenerator::runClients, this, ref(groups[t]), ref(results[t])));
+        for (thread &worker : threads)
+            worker.join();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+        // Closing a connection releases whatever its cart still holds
+        for (vector<LoadClient> &group : groups)
+            for (LoadClient &client : group)
+                if (client.fd >= 0)
+                    close(client.fd);
+
+        LoadResults total;
+        for (LoadResults &part : results)
+        {
+            total.latencies.insert(total.latencies.end(), part.latencies.begin(), part.latencies.end());
+            total.ok += part.ok;
+            total.refused += part.refused;
+            total.errors += part.errors;
+            total.timedOut = total.timedOut || part.timedOut;
+        }
+        sort(total.latencies.begin(), total.latencies.end());
+        size_t requests = total.latencies.size();
+        auto percentile = [&](double fraction) -> uint32_t
+        {
+            if (requests == 0) return 0;
+            return total.latencies[min(requests - 1, size_t(fraction * requests))];
+        };
 
-// -------------- BUYER MENU --------------
-void Shopping::buyer()
+        cout << "Requests: " << requests << " in " << seconds << " s ("
+             << size_t(requests / max(seconds, 1e-9)) << " requests/s)\n";
+        cout << "OK: " << total.ok << ", refused: " << total.refused << ", errors: " << total.errors << "\n";
+        cout << "Latency (us): p50 " << percentile(0.50) << ", p90 " << percentile(0.90) << ", p99 "
+             << percentile(0.99) << ", p99.9 " << percentile(0.999) << ", max "
+             << (requests ? total.latencies.back() : 0) << "\n";
+        if (total.timedOut)
+            cout << "Warning: The server stopped answering; results are partial.\n";
+        return total.errors == 0 && !total.timedOut ? 0 : 1;
+    }
+};
+
+// ======================================
+// Index Benchmark
+// ======================================
+// Compares the B+ tree product index against a balanced tree with one
+// allocated node per product, the layout the catalog used before it: a
+// load in random code order, random point lookups and full scans in code
+// order. Runs in memory; the catalog files are not touched.
+class IndexBenchmark
 {
-    int choice;
-    do
+private:
+    typedef chrono::steady_clock Clock;
+
+    static double millisecondsSince(Clock::time_point started)
     {
-        cout << "\nBuyer Menu\n";
-        cout << "=========================\n";
-        cout << "1) Login\n";
-        cout << "2) Register\n";
-        cout << "3) Add to Cart\n";
-        cout << "4) Modify Cart\n";
-        cout << "5) Display Cart\n";
-        cout << "6) Place Order\n";
-        cout << "7) View Order History\n";
-        cout << "8) Add to Wishlist\n";
-        cout << "9) View Wishlist\n";
-        cout << "10) Logout\n";
-        cout << "11) Back to Main Menu\n";
-        cout << "=========================\n";
-        cout << "Enter your choice: ";
-        cin >> choice;
+        return chrono::duration<double, milli>(Clock::now() - started).count();
+    }
 
-        switch (choice)
+    static void report(const char *phase, double tree, double index)
+    {
+        char line[96];
+        snprintf(line, sizeof(line), "  %-20s %14.0f ms %14.0f ms\n", phase, tree, index);
+        cout << line;
+    }
+
+public:
+    int run(int productCount)
+    {
+        if (productCount <= 0)
         {
-        case 1:
-            customerLogin();
-            break;
-        case 2:
-            customerRegistration();
-            break;
-        case 3:
+            cout << "Error: The product count must be positive.\n";
+            return 1;
+        }
+        const int lookups = 2 * productCount;
+        const int scans = 10;
+
+        mt19937 random(12345);
+        vector<int> codes(productCount);
+        for (int i = 0; i < productCount; i++)
+            codes[i] = i + 1;
+        shuffle(codes.begin(), codes.end(), random);
+        vector<int> probes(lookups);
+        for (int i = 0; i < lookups; i++)
+            probes[i] = 1 + int(random() % uint32_t(productCount));
+
+        auto fill = [](Product &product, int code)
+        {
+            product.code = code;
+            product.name = "Product " + to_string(code);
+            product.price = 1.0f + code % 100;
+            product.discount = 0;
+            product.stock = code % 50;
+            product.category = "Category" + to_string(code % 20);
+            product.left = nullptr;
+            product.categoryId = 0;
+            product.bookedStock = code % 50;
+        };
+
+        // Each phase sums what it reads so the work cannot be optimized away
+        double checksum = 0;
+        double treeTimes[3], indexTimes[3];
+
+        {
+            map<int, Product> tree;
+            Clock::time_point started = Clock::now();
+            for (int code : codes)
+                fill(tree[code], code);
+            treeTimes[0] = millisecondsSince(started);
+
+            started = Clock::now();
+            for (int code : probes)
+                checksum += tree.find(code)->second.price;
+            treeTimes[1] = millisecondsSince(started);
+
+            started = Clock::now();
+            for (int pass = 0; pass < scans; pass++)
+                for (const pair<const int, Product> &entry : tree)
+                    checksum += entry.second.price * entry.second.stock;
+            treeTimes[2] = millisecondsSince(started);
+        }
+
         {
-            if (!currentCustomer)
+            ProductArena arena;
+            ProductIndex index;
+            Clock::time_point started = Clock::now();
+            for (int code : codes)
             {
-                cout << "Please log in to add items to your cart.\n";
-                break;
+                Product *product = arena.allocate();
+                fill(*product, code);
+                index.insert(product);
             }
-            int code, quantity;
-            cout << "Enter Product Code: ";
-            cin >> code;
-            cout << "Enter Quantity: ";
-            cin >> quantity;
-            addToCart(code, quantity);
-            break;
+            indexTimes[0] = millisecondsSince(started);
+
+            started = Clock::now();
+            for (int code : probes)
+                checksum += index.find(code)->price;
+            indexTimes[1] = millisecondsSince(started);
+
+            started = Clock::now();
+            for (int pass = 0; pass < scans; pass++)
+                for (const Product *product : index)
+                    checksum += product->price * product->stock;
+            indexTimes[2] = millisecondsSince(started);
         }
-        case 4:
+
+        cout << productCount << " products, inserted in random code order (checksum " << checksum << ")\n";
+        char header[96];
+        snprintf(header, sizeof(header), "  %-20s %17s %17s\n", "", "node per product", "B+ tree");
+        cout << header;
+        report("load", treeTimes[0], indexTimes[0]);
+        report((to_string(lookups) + " lookups").c_str(), treeTimes[1], indexTimes[1]);
+        report((to_string(scans) + " full scans").c_str(), treeTimes[2], indexTimes[2]);
+        return 0;
+    }
+};
+
+// ======================================
+// Stock Stress Test
+// ======================================
+// Runs concurrent sessions against one product through the request
+// dispatcher: each adds units to its cart, gives some back and places
+// orders, with far more demand than stock. Every answer reports the stock
+// left, which must never be negative, and once the sessions have closed
+// (releasing their carts) the stock left plus the units sold must equal
+// the stock the product started with. Runs in a scratch directory that
+// is removed afterwards.
+const int STRESS_INITIAL_STOCK = 1000;
+
+class StressTest
+{
+private:
+    struct SessionResult
+    {
+        long long sold;   // units in orders placed
+        long long held;   // units in the cart at the end
+        long long negative; // answers that reported stock below zero
+        long long refused;  // ADDs turned away for lack of stock
+    };
+
+    // Scratch files: the catalog, journal, ledger, customers and logs
+    static void removeDirectory(const string &path)
+    {
+        DIR *dir = opendir(path.c_str());
+        if (dir)
         {
-            if (!currentCustomer)
+            struct dirent *entry;
+            while ((entry = readdir(dir)) != nullptr)
             {
-                cout << "Please log in to modify your cart.\n";
-                break;
+                if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0)
+                    remove((path + "/" + entry->d_name).c_str());
             }
-            modifyCart();
-            break;
+            closedir(dir);
         }
-        case 5:
+        rmdir(path.c_str());
+    }
+
+    // Stock from a "PRODUCT 1" answer: the fifth field of its row
+    static int stockOf(const string &response)
+    {
+        size_t row = response.find('\n');
+        int code, stock;
+        float price, discount;
+        char name[256];
+        if (row == string::npos
+            || sscanf(response.c_str() + row + 1, "%d\t%255[^\t]\t%f\t%f\t%d", &code, name, &price, &discount, &stock) != 5)
+            return -1;
+        return stock;
+    }
+
+    static void runSession(Shopping &shop, Session &session, int id, int operations, SessionResult &result)
+    {
+        mt19937 random(uint32_t(id) * 2654435761u + 7);
+        string response;
+        long long inCart = 0;
+        for (int i = 0; i < operations; i++)
         {
-            if (!currentCustomer)
+            int pick = int(random() % 100);
+            ShopStatus status;
+            if (pick < 65)
             {
-                cout << "Please log in to display your cart.\n";
-                break;
+                status = shop.execute(session, "ADD 1 " + to_string(1 + random() % 4), response);
+                if (status == SHOP_NO_STOCK)
+                    result.refused++;
             }
-            displayCart();
-            break;
+            else if (pick < 95)
+            {
+                status = shop.execute(session, "SET 1 " + to_string(inCart / 2), response);
+            }
+            else
+            {
+                status = shop.execute(session, "ORDER", response);
+                if (status == SHOP_OK)
+                {
+                    result.sold += inCart;
+                    inCart = 0;
+                }
+                continue;
+            }
+
+            // "OK <in cart> <stock left>", or "ERR no-stock <stock left>"
+            long long quantity = inCart, stockLeft = 0;
+            if (status == SHOP_OK)
+                sscanf(response.c_str(), "OK %lld %lld", &quantity, &stockLeft);
+            else if (status == SHOP_NO_STOCK)
+                sscanf(response.c_str(), "ERR no-stock %lld", &stockLeft);
+            inCart = quantity;
+            if (stockLeft < 0)
+                result.negative++;
         }
-        case 6:
+        result.held = inCart;
+    }
+
+public:
+    int run(int sessionCount, int operations)
+    {
+        if (sessionCount <= 0 || operations <= 0)
+        {
+            cout << "Error: Sessions and operations must be positive.\n";
+            return 1;
+        }
+
+        char scratch[] = "/tmp/supermarket-stress.XXXXXX";
+        char original[4096];
+        if (!getcwd(original, sizeof(original)) || !mkdtemp(scratch) || chdir(scratch) != 0)
         {
-            if (!currentCustomer)
+            cout << "Error: Unable to create a scratch directory.\n";
+            return 1;
+        }
+        {
+            ofstream products("products.txt");
+            products << "1 StressItem 2.5 0 " << STRESS_INITIAL_STOCK << " Stress\n";
+        }
+
+        vector<SessionResult> results(sessionCount, SessionResult{0, 0, 0, 0});
+        int finalStock = -1;
+        double seconds = 0;
+        {
+            Shopping shop;
+            shop.loadProductsOnStartup();
+
+            vector<unique_ptr<Session> > sessions;
+            string response;
+            for (int id = 0; id < sessionCount; id++)
             {
-                cout << "Please log in to place an order.\n";
-                break;
+                sessions.push_back(unique_ptr<Session>(new Session));
+                shop.openSession(*sessions.back());
+                shop.execute(*sessions.back(), "REGISTER stress" + to_string(id) + " pw", response);
             }
-            placeOrder();
-            break;
+
+            chrono::steady_clock::time_point started = chrono::steady_clock::now();
+            vector<thread> workers;
+            for (int id = 0; id < sessionCount; id++)
+                workers.push_back(thread(&StressTest::runSession, ref(shop), ref(*sessions[id]), id, operations,
+                                         ref(results[id])));
+            for (thread &worker : workers)
+                worker.join();
+            seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+            for (unique_ptr<Session> &session : sessions)
+                shop.closeSession(*session);
+            Session observer;
+            shop.execute(observer, "PRODUCT 1", response);
+            finalStock = stockOf(response);
+            shop.saveAllProducts();
         }
-        case 7:
+
+        if (chdir(original) != 0)
+            cout << "Warning: Unable to return to " << original << ".\n";
+        removeDirectory(scratch);
+
+        long long sold = 0, held = 0, negative = 0, refused = 0;
+        for (const SessionResult &result : results)
+        {
+            sold += result.sold;
+            held += result.held;
+            negative += result.negative;
+            refused += result.refused;
+        }
+        bool conserved = finalStock + sold == STRESS_INITIAL_STOCK;
+
+        cout << sessionCount << " sessions x " << operations << " operations in " << seconds << " s\n";
+        cout << "Initial stock " << STRESS_INITIAL_STOCK << ", sold " << sold << ", left " << finalStock
+             << " (" << held << " released from carts at the end), refused ADDs " << refused << "\n";
+        cout << "Stock never negative: " << (negative == 0 ? "yes" : "NO") << "\n";
+        cout << "Stock left + sold == initial stock: " << (conserved ? "yes" : "NO") << "\n";
+        return negative == 0 && conserved ? 0 : 1;
+    }
+};
+
+// ======================================
+// Batch Mode
+// ======================================
+// Runs protocol requests (see Shopping::execute) from a file or stdin, one
+// per line, as a single session without prompts. Blank lines and lines
+// starting with '#' are skipped, and QUIT ends the batch. Each request
+// prints its line number and the first line of its answer; listed rows
+// are left out. Up to BATCH_COMMIT_GROUP requests share one journal sync,
+// and a group's status lines are printed once it is on disk. If that
+// fails, the group's successful requests are reported as storage errors.
+// An order commits the group before it first, so the ledger never records
+// a sale whose stock change could still be lost.
+const size_t BATCH_COMMIT_GROUP = 256;
+
+class BatchRunner
+{
+private:
+    struct PendingStatus
+    {
+        size_t lineNumber;
+        ShopStatus status;
+        string line;        // first line of the answer
+    };
+
+    Shopping &shop;
+    Session session;
+    vector<PendingStatus> uncommitted;
+    size_t statusCounts[SHOP_STORAGE_ERROR + 1];
+    vector<uint32_t> latencies; // microseconds
+
+    void commit()
+    {
+        bool committed = shop.commitChanges();
+        string lines;
+        for (const PendingStatus &pending : uncommitted)
         {
-            if (!currentCustomer)
+            lines += to_string(pending.lineNumber) + " ";
+            if (committed || pending.status != SHOP_OK)
             {
-                cout << "Please log in to view your order history.\n";
-                break;
+                lines += pending.line;
+                continue;
             }
-            viewOrderHistory();
-            break;
+            statusCounts[SHOP_OK]--;
+            statusCounts[SHOP_STORAGE_ERROR]++;
+            lines += string("ERR ") + statusName(SHOP_STORAGE_ERROR) + "\n";
         }
-        case 8:
+        cout << lines;
+        uncommitted.clear();
+    }
+
+    void runRequest(size_t lineNumber, const string &request)
+    {
+        string command, response;
+        istringstream(request) >> command;
+        transform(command.begin(), command.end(), command.begin(), ::toupper);
+        if (command == "ORDER" && !uncommitted.empty())
+            commit();
+
+        chrono::steady_clock::time_point started = chrono::steady_clock::now();
+        ShopStatus status = shop.execute(session, request, response, false);
+        latencies.push_back(uint32_t(chrono::duration_cast<chrono::microseconds>(
+            chrono::steady_clock::now() - started).count()));
+        statusCounts[status]++;
+
+        PendingStatus pending;
+        pending.lineNumber = lineNumber;
+        pending.status = status;
+        pending.line.assign(response, 0, response.find('\n') + 1);
+        uncommitted.push_back(pending);
+        if (uncommitted.size() >= BATCH_COMMIT_GROUP)
+            commit();
+    }
+
+public:
+    explicit BatchRunner(Shopping &shopping) : shop(shopping)
+    {
+        fill(statusCounts, statusCounts + SHOP_STORAGE_ERROR + 1, size_t(0));
+        shop.openSession(session);
+    }
+
+    // Whatever the batch left in its cart goes back to stock
+    ~BatchRunner() { shop.closeSession(session); }
+
+    // Reads stdin when the path is empty or "-"
+    int run(const string &path)
+    {
+        ifstream file;
+        if (!path.empty() && path != "-")
         {
-            if (!currentCustomer)
+            file.open(path);
+            if (!file)
             {
-                cout << "Please log in to add items to wishlist.\n";
-                break;
+                cout << "Error: Unable to open " << path << ".\n";
+                return 1;
             }
-            int code;
-            cout << "Enter Product Code to Add to Wishlist: ";
-            cin >> code;
-            addToWishlist(code);
-            break;
         }
-        case 9:
+        istream &input = file.is_open() ? static_cast<istream &>(file) : cin;
+
+        chrono::steady_clock::time_point started = chrono::steady_clock::now();
+        string line;
+        size_t lineNumber = 0;
+        while (getline(input, line))
         {
-            if (!currentCustomer)
-            {
-                cout << "Please log in first.\n";
+            lineNumber++;
+            if (!line.empty() && line[line.size() - 1] == '\r')
+                line.erase(line.size() - 1);
+            size_t first = line.find_first_not_of(" \t");
+            if (first == string::npos || line[first] == '#')
+                continue;
+            string command;
+            istringstream(line) >> command;
+            transform(command.begin(), command.end(), command.begin(), ::toupper);
+            if (command == "QUIT")
                 break;
-            }
-            viewWishlist();
-            break;
+            runRequest(lineNumber, line);
         }
-        case 10:
-            currentCustomer = nullptr;
-            cout << "Logged out successfully.\n";
-            return;
-        case 11:
-            return; // back to main menu
-        default:
-            cout << "Invalid choice. Please try again.\n";
+        commit();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+        sort(latencies.begin(), latencies.end());
+        size_t requests = latencies.size();
+        auto percentile = [&](double fraction) -> uint32_t
+        {
+            if (requests == 0) return 0;
+            return latencies[min(requests - 1, size_t(fraction * requests))];
+        };
+
+        cout << "Requests: " << requests << " in " << seconds << " s ("
+             << size_t(requests / max(seconds, 1e-9)) << " requests/s)\n";
+        cout << "Status:";
+        const char *separator = " ";
+        for (int status = SHOP_OK; status <= SHOP_STORAGE_ERROR; status++)
+        {
+            if (statusCounts[status] == 0)
+                continue;
+            cout << separator << statusName(ShopStatus(status)) << " " << statusCounts[status];
+            separator = ", ";
         }
-    } while (true);
-}
+        cout << "\n";
+        cout << "Latency (us): p50 " << percentile(0.50) << ", p99 " << percentile(0.99) << ", max "
+             << (requests ? latencies.back() : 0) << "\n";
+        return 0;
+    }
+};
 
 // -------------- MAIN --------------
-int main()
+// supermarket                                  interactive menus
+// supermarket --serve <address> [workers]      socket server
+// supermarket --loadgen <address> [clients] [requests per client]
+// supermarket --batch [file]                   requests from a file or stdin
+// supermarket --bench [products]               product index benchmark
+// supermarket --stress [sessions] [operations] concurrent stock stress test
+int main(int argc, char *argv[])
 {
+    string mode = argc > 1 ? argv[1] : "";
+    if (mode == "--stress")
+    {
+        StressTest test;
+        return test.run(argc > 2 ? atoi(argv[2]) : 8, argc > 3 ? atoi(argv[3]) : 2000);
+    }
+    if (mode == "--bench")
+    {
+        IndexBenchmark benchmark;
+        return benchmark.run(argc > 2 ? atoi(argv[2]) : 1000000);
+    }
+    if (mode == "--loadgen")
+    {
+        if (argc < 3)
+        {
+            cout << "Usage: " << argv[0] << " --loadgen <address> [clients] [requests per client]\n";
+            return 1;
+        }
+        LoadGenerator generator;
+        return generator.run(argv[2], argc > 3 ? atoi(argv[3]) : 100, argc > 4 ? atoi(argv[4]) : 1000);
+    }
+
+    bool serving = mode == "--serve";
+    if (serving && argc < 3)
+    {
+        cout << "Usage: " << argv[0] << " --serve <port | host:port | socket path> [workers]\n";
+        return 1;
+    }
+    if (serving)
+        ShopServer::blockStopSignals();
+
     Shopping shop;
     shop.loadProductsOnStartup();
-    shop.menu();
+    int result = 0;
+    if (mode == "--batch")
+    {
+        BatchRunner batch(shop);
+        result = batch.run(argc > 2 ? argv[2] : "");
+    }
+    else if (serving)
+    {
+        ShopServer server(shop);
+        size_t workers = argc > 3 ? size_t(atoi(argv[3])) : max(thread::hardware_concurrency(), 1u);
+        if (server.start(argv[2], workers))
+            server.run();
+    }
+    else
+    {
+        shop.menu();
+    }
     shop.saveAllProducts();
-    return 0;
+    return result;
 }